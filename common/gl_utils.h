@@ -6,6 +6,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <string_view>
 
 inline std::string LoadTextFile(const std::string &path) {
   // Le o ficheiro inteiro para memoria
@@ -18,11 +19,12 @@ inline std::string LoadTextFile(const std::string &path) {
   return buffer.str();
 }
 
-inline GLuint CompileShader(GLenum type, const std::string &source, const std::string &label) {
-  // Compila um shader e devolve o id
+inline GLuint CompileShader(GLenum type, std::string_view source, const std::string &label) {
+  // Compila um shader e devolve o id (o texto não precisa de terminar em '\0')
   GLuint shader = glCreateShader(type);
-  const char *src = source.c_str();
-  glShaderSource(shader, 1, &src, nullptr);
+  const char *src = source.data();
+  GLint length = static_cast<GLint>(source.size());
+  glShaderSource(shader, 1, &src, &length);
   glCompileShader(shader);
 
   GLint compiled = 0;
@@ -40,17 +42,11 @@ inline GLuint CompileShader(GLenum type, const std::string &source, const std::s
   return shader;
 }
 
-inline GLuint CreateProgram(const std::string &vertexPath, const std::string &fragmentPath) {
-  // Carrega, compila e linka os shaders
-  std::string vertexSrc = LoadTextFile(vertexPath);
-  std::string fragmentSrc = LoadTextFile(fragmentPath);
-  if (vertexSrc.empty() || fragmentSrc.empty()) {
-    std::cerr << "Nao foi possivel ler os shaders em " << vertexPath << " e " << fragmentPath << "\n";
-    return 0;
-  }
-
-  GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSrc, vertexPath);
-  GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSrc, fragmentPath);
+inline GLuint CreateProgramFromSource(std::string_view vertexSrc, std::string_view fragmentSrc,
+                                      const std::string &vertexLabel, const std::string &fragmentLabel) {
+  // Compila e linka os shaders a partir do texto já carregado
+  GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSrc, vertexLabel);
+  GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSrc, fragmentLabel);
   if (!vertexShader || !fragmentShader) {
     return 0;
   }
@@ -77,3 +73,14 @@ inline GLuint CreateProgram(const std::string &vertexPath, const std::string &fr
 
   return program;
 }
+
+inline GLuint CreateProgram(const std::string &vertexPath, const std::string &fragmentPath) {
+  // Carrega, compila e linka os shaders
+  std::string vertexSrc = LoadTextFile(vertexPath);
+  std::string fragmentSrc = LoadTextFile(fragmentPath);
+  if (vertexSrc.empty() || fragmentSrc.empty()) {
+    std::cerr << "Nao foi possivel ler os shaders em " << vertexPath << " e " << fragmentPath << "\n";
+    return 0;
+  }
+  return CreateProgramFromSource(vertexSrc, fragmentSrc, vertexPath, fragmentPath);
+}
@@ -116,6 +116,14 @@ inline Mat4 Mat4RotateY(float angleRadians) {
   return out;
 }
 
+// Maior escala dos eixos da matriz (para o raio de esferas transformadas)
+inline float Mat4MaxScale(const Mat4 &m) {
+  float sx = m.m[0] * m.m[0] + m.m[1] * m.m[1] + m.m[2] * m.m[2];
+  float sy = m.m[4] * m.m[4] + m.m[5] * m.m[5] + m.m[6] * m.m[6];
+  float sz = m.m[8] * m.m[8] + m.m[9] * m.m[9] + m.m[10] * m.m[10];
+  return std::sqrt(std::fmax(sx, std::fmax(sy, sz)));
+}
+
 // Projecao em perspectiva
 inline Mat4 Mat4Perspective(float fovyRadians, float aspect, float zNear, float zFar) {
   Mat4 out;
@@ -152,3 +160,50 @@ inline Mat4 Mat4LookAt(const Vec3 &eye, const Vec3 &target, const Vec3 &up) {
   out.m[14] = Dot(f, eye);
   return out;
 }
+
+// Plano normal.p + d = 0, com a normal unitária a apontar para dentro
+struct Plane {
+  Vec3 normal;
+  float d = 0.0f;
+};
+
+struct Frustum {
+  // Esquerdo, direito, baixo, cima, perto e longe
+  Plane planes[6];
+};
+
+// Planos do frustum a partir de proj*view (Gribb/Hartmann): somas e
+// diferenças da última linha com as outras
+inline Frustum ExtractFrustum(const Mat4 &viewProj) {
+  const float *m = viewProj.m;
+  Frustum frustum;
+  for (int i = 0; i < 6; ++i) {
+    int row = i / 2;
+    float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+    float a = m[3] + sign * m[row];
+    float b = m[7] + sign * m[4 + row];
+    float c = m[11] + sign * m[8 + row];
+    float d = m[15] + sign * m[12 + row];
+    float length = std::sqrt(a * a + b * b + c * c);
+    if (length > 0.0f) {
+      a /= length;
+      b /= length;
+      c /= length;
+      d /= length;
+    }
+    frustum.planes[i].normal = {a, b, c};
+    frustum.planes[i].d = d;
+  }
+  return frustum;
+}
+
+// Esfera toca o frustum (pode dar falso positivo perto dos cantos)
+inline bool SphereInFrustum(const Frustum &frustum, const Vec3 &center,
+                            float radius) {
+  for (const Plane &plane : frustum.planes) {
+    if (Dot(plane.normal, center) + plane.d < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
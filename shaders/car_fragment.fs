@@ -4,15 +4,32 @@
 in vec3 vNormal;      // Normal da superfície interpolada
 in vec2 vTexCoord;    // Coordenadas de textura interpoladas
 in vec3 vWorldPos;    // Posição do vértice no mundo
-
-// Parâmetros uniformes definidos pela aplicação
-uniform vec3 uColor;           // Cor base do objeto
-uniform vec3 uLightDir;        // Direção da luz principal
-uniform vec3 uLightDir2;       // Direção da luz secundária (preenchimento)
-uniform vec3 uAmbient;         // Luz ambiente
-uniform vec3 uViewPos;         // Posição da câmera
-uniform sampler2D uTexture;    // Textura a ser aplicada
-uniform bool uUseTexture;      // Usa textura ou não?
+in vec4 vTint;        // Cor da instância (branco fora dos lotes)
+
+// Câmara e luzes do frame (o mesmo bloco do vertex shader)
+layout(std140) uniform Frame {
+  mat4 uView;
+  mat4 uProj;
+  vec3 uLightDir;   // Direção da luz principal
+  vec3 uLightDir2;  // Direção da luz secundária (preenchimento)
+  vec3 uAmbient;    // Luz ambiente
+  vec3 uViewPos;    // Posição da câmera
+};
+
+// Entrada do material em uMaterials (muda por mesh)
+uniform int uMaterial;
+
+// Materiais do modelo (UBO ligado pela aplicação)
+struct Material {
+  vec4 kd;        // Cor difusa (rgb)
+  ivec4 params;   // Array, camada, tem textura, padding
+};
+layout(std140) uniform Materials {
+  Material uMaterials[64];
+};
+
+// Um array por tamanho de camada (unidades 0..3)
+uniform sampler2DArray uTextureArrays[4];
 
 // Saída da cor final do fragmento
 out vec4 FragColor;
@@ -52,12 +69,27 @@ void main() {
   // Combina os brilhos e aplica força
   float spec = specStrength * (spec1 + spec2);
 
-  // Define a cor base: usa textura se ativada, senão usa a cor uniforme
-  vec3 baseColor = uColor;
-  if (uUseTexture) {
-    baseColor = texture(uTexture, vTexCoord).rgb;
+  // Define a cor base: textura do material se tiver, senão a cor difusa
+  Material material = uMaterials[uMaterial];
+  vec3 baseColor = material.kd.rgb;
+  if (material.params.z != 0) {
+    // Em GLSL 3.30 o array de samplers só aceita índices constantes
+    vec3 uvw = vec3(vTexCoord, float(material.params.y));
+    int group = material.params.x;
+    if (group == 0) {
+      baseColor = texture(uTextureArrays[0], uvw).rgb;
+    } else if (group == 1) {
+      baseColor = texture(uTextureArrays[1], uvw).rgb;
+    } else if (group == 2) {
+      baseColor = texture(uTextureArrays[2], uvw).rgb;
+    } else {
+      baseColor = texture(uTextureArrays[3], uvw).rgb;
+    }
   }
 
+  // Cor de cada carro do trânsito
+  baseColor *= vTint.rgb;
+
   // Combina ambiente, difusa e especular
   vec3 color = uAmbient + baseColor * diff + vec3(spec);
 
@@ -0,0 +1,70 @@
+#version 330 core
+
+// Define as entradas do vértice com seus respectivos locais
+layout(location = 0) in vec3 aPos;      // Posição do vértice
+layout(location = 1) in vec3 aNormal;   // Normal do vértice
+layout(location = 2) in vec2 aTexCoord; // Coordenadas de textura
+// Atributos de instância (divisor 1, um valor por carro do lote)
+layout(location = 3) in mat4 aInstanceModel; // Matriz de modelo (ocupa 3..6)
+layout(location = 7) in vec4 aInstanceTint;  // Cor do carro
+
+// Câmara e luzes do frame (UBO partilhado por todos os programas, escrito
+// uma vez por frame)
+layout(std140) uniform Frame {
+  mat4 uView;       // Matriz de visão (mundo -> câmera)
+  mat4 uProj;       // Matriz de projeção (câmera -> tela)
+  vec3 uLightDir;   // Direção da luz principal
+  vec3 uLightDir2;  // Direção da luz secundária
+  vec3 uAmbient;    // Luz ambiente
+  vec3 uViewPos;    // Posição da câmera
+};
+
+// Dados do lote (entrada do UBO de objetos do frame); a matriz vem de
+// cada instância e uModel fica a identidade
+layout(std140) uniform Object {
+  mat4 uModel;       // Não usada aqui
+  // Descodificação do formato de vértice compacto (identidade no formato float)
+  vec3 uPosOffset;   // Mínimo da AABB do modelo
+  vec3 uPosScale;    // Tamanho da AABB (posição chega normalizada em [0,1])
+  int uOctNormals;   // Normal em octaedro (2 componentes em aNormal.xy)
+};
+
+// Saídas para o próximo estágio do pipeline (fragment shader)
+out vec3 vNormal;     // Normal transformada para o espaço do mundo
+out vec2 vTexCoord;   // Coordenadas de textura repassadas
+out vec3 vWorldPos;   // Posição do vértice no espaço do mundo
+out vec4 vTint;       // Cor que multiplica a do material
+
+// Reconstrói a normal a partir da codificação em octaedro
+vec3 OctDecode(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  if (n.z < 0.0) {
+    vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    n.xy = (1.0 - abs(n.yx)) * signs;
+  }
+  return normalize(n);
+}
+
+void main() {
+  // Descodifica posição e normal (no formato float não muda nada)
+  vec3 position = uPosOffset + aPos * uPosScale;
+  vec3 normal = uOctNormals != 0 ? OctDecode(aNormal.xy) : aNormal;
+
+  // Transforma a posição do vértice para o espaço do mundo
+  vec4 worldPos = aInstanceModel * vec4(position, 1.0);
+
+  // Transforma a normal para o espaço do mundo (sem translação)
+  vNormal = mat3(aInstanceModel) * normal;
+
+  // Passa as coordenadas de textura para o fragment shader
+  vTexCoord = aTexCoord;
+
+  // Passa a posição no mundo para o fragment shader
+  vWorldPos = worldPos.xyz;
+
+  // Cor do carro para o fragment shader
+  vTint = aInstanceTint;
+
+  // Calcula a posição final do vértice na tela
+  gl_Position = uProj * uView * worldPos;
+}
\ No newline at end of file
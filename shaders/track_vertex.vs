@@ -5,22 +5,51 @@ layout(location = 0) in vec3 aPos;      // Posição do vértice
 layout(location = 1) in vec3 aNormal;   // Normal do vértice
 layout(location = 2) in vec2 aTexCoord; // Coordenadas de textura
 
-// Matrizes de transformação definidas pela aplicação
-uniform mat4 uModel;  // Matriz de modelo (objeto -> mundo)
-uniform mat4 uView;   // Matriz de visão (mundo -> câmera)
-uniform mat4 uProj;   // Matriz de projeção (câmera -> tela)
+// Câmara e luzes do frame (UBO partilhado por todos os programas, escrito
+// uma vez por frame)
+layout(std140) uniform Frame {
+  mat4 uView;       // Matriz de visão (mundo -> câmera)
+  mat4 uProj;       // Matriz de projeção (câmera -> tela)
+  vec3 uLightDir;   // Direção da luz principal
+  vec3 uLightDir2;  // Direção da luz secundária
+  vec3 uAmbient;    // Luz ambiente
+  vec3 uViewPos;    // Posição da câmera
+};
+
+// Dados do objeto (entrada do UBO de objetos do frame)
+layout(std140) uniform Object {
+  mat4 uModel;       // Matriz de modelo (objeto -> mundo)
+  // Descodificação do formato de vértice compacto (identidade no formato float)
+  vec3 uPosOffset;   // Mínimo da AABB do modelo
+  vec3 uPosScale;    // Tamanho da AABB (posição chega normalizada em [0,1])
+  int uOctNormals;   // Normal em octaedro (2 componentes em aNormal.xy)
+};
 
 // Saídas para o próximo estágio do pipeline (fragment shader)
 out vec3 vNormal;     // Normal transformada para o espaço do mundo
 out vec2 vTexCoord;   // Coordenadas de textura repassadas
 out vec3 vWorldPos;   // Posição do vértice no espaço do mundo
 
+// Reconstrói a normal a partir da codificação em octaedro
+vec3 OctDecode(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  if (n.z < 0.0) {
+    vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    n.xy = (1.0 - abs(n.yx)) * signs;
+  }
+  return normalize(n);
+}
+
 void main() {
+  // Descodifica posição e normal (no formato float não muda nada)
+  vec3 position = uPosOffset + aPos * uPosScale;
+  vec3 normal = uOctNormals != 0 ? OctDecode(aNormal.xy) : aNormal;
+
   // Transforma a posição do vértice para o espaço do mundo
-  vec4 worldPos = uModel * vec4(aPos, 1.0);
+  vec4 worldPos = uModel * vec4(position, 1.0);
 
   // Transforma a normal para o espaço do mundo (sem translação)
-  vNormal = mat3(uModel) * aNormal;
+  vNormal = mat3(uModel) * normal;
 
   // Passa as coordenadas de textura para o fragment shader
   vTexCoord = aTexCoord;
@@ -0,0 +1,65 @@
+#include "assets/arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+void *ArenaAllocate(Arena &arena, size_t bytes, size_t alignment) {
+  if (bytes == 0) {
+    return nullptr;
+  }
+  // Tenta no último bloco; só ele pode ter espaço livre útil
+  if (!arena.blocks.empty()) {
+    ArenaBlock &block = arena.blocks.back();
+    uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+    uintptr_t aligned =
+        (base + block.used + alignment - 1) / alignment * alignment;
+    size_t offset = aligned - base;
+    if (offset + bytes <= block.size) {
+      block.used = offset + bytes;
+      return block.data.get() + offset;
+    }
+  }
+
+  // Bloco novo; pedidos grandes ficam com um bloco à medida
+  ArenaBlock block;
+  block.size = std::max(arena.blockSize, bytes + alignment);
+  block.data.reset(new unsigned char[block.size]);
+  uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+  size_t offset = (base + alignment - 1) / alignment * alignment - base;
+  block.used = offset + bytes;
+  arena.reservedBytes += block.size;
+  arena.peakBytes = std::max(arena.peakBytes, arena.reservedBytes);
+  arena.blocks.push_back(std::move(block));
+  return arena.blocks.back().data.get() + offset;
+}
+
+void ResetArena(Arena &arena) {
+  arena.blocks.clear();
+  arena.blocks.shrink_to_fit();
+  arena.reservedBytes = 0;
+}
+
+size_t PeakResidentBytes() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    // "VmHWM:     14652 kB"
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return static_cast<size_t>(std::strtoull(line.c_str() + 6, nullptr, 10)) *
+             1024;
+    }
+  }
+  return 0;
+}
+
+void ResetPeakResidentBytes() {
+  // "5" em clear_refs repõe o VmHWM no RSS atual
+  if (FILE *file = std::fopen("/proc/self/clear_refs", "w")) {
+    std::fputs("5", file);
+    std::fclose(file);
+  }
+}
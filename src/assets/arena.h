@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+struct ArenaBlock {
+  std::unique_ptr<unsigned char[]> data;
+  size_t size = 0;
+  size_t used = 0;
+};
+
+struct Arena {
+  // Blocos reservados; nada é libertado até ResetArena
+  std::vector<ArenaBlock> blocks;
+  // Tamanho mínimo de cada bloco novo
+  size_t blockSize = 1024 * 1024;
+  // Bytes reservados agora e no máximo desde a criação
+  size_t reservedBytes = 0;
+  size_t peakBytes = 0;
+};
+
+// Reserva bytes alinhados na arena (não é thread-safe: reservar tudo antes
+// de repartir o trabalho pelas threads)
+void *ArenaAllocate(Arena &arena, size_t bytes, size_t alignment);
+// Liberta todos os blocos de uma vez (os ponteiros deixam de ser válidos)
+void ResetArena(Arena &arena);
+
+// Array de capacidade fixa dentro de uma arena: push_back nunca realoca,
+// por isso a capacidade tem de vir de uma contagem prévia
+template <typename T> struct FixedArray {
+  static_assert(std::is_trivially_destructible_v<T>,
+                "a arena não chama destrutores");
+  T *items = nullptr;
+  size_t count = 0;
+  size_t capacity = 0;
+
+  void push_back(const T &value) { items[count++] = value; }
+  // Só encolhe (descarta o fim)
+  void resize(size_t newCount) { count = newCount; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  T *data() { return items; }
+  const T *data() const { return items; }
+  T &operator[](size_t i) { return items[i]; }
+  const T &operator[](size_t i) const { return items[i]; }
+  T *begin() { return items; }
+  T *end() { return items + count; }
+  const T *begin() const { return items; }
+  const T *end() const { return items + count; }
+};
+
+// Array vazio com espaço para capacity elementos
+template <typename T>
+FixedArray<T> ArenaArray(Arena &arena, size_t capacity) {
+  FixedArray<T> array;
+  array.items = static_cast<T *>(
+      ArenaAllocate(arena, capacity * sizeof(T), alignof(T)));
+  array.capacity = capacity;
+  return array;
+}
+
+// Pico de memória residente do processo em bytes (VmHWM; 0 se indisponível)
+size_t PeakResidentBytes();
+// Recomeça a medição do pico (só Linux; sem efeito se não for permitido).
+// Afeta o processo inteiro: só para ferramentas que medem uma coisa de cada
+// vez (bench_assets), nunca no loader
+void ResetPeakResidentBytes();
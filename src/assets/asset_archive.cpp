@@ -0,0 +1,198 @@
+#include "assets/asset_archive.h"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+
+#include "assets/cache_io.h"
+#include "gl_utils.h"
+
+namespace {
+// Formato: cabeçalho, dados de cada ficheiro alinhados à página e índice
+// no fim (caminho, offset, tamanho)
+const char kMagic[4] = {'P', 'P', 'A', 'K'};
+const uint32_t kVersion = 1;
+// Alinhamento à página: cada entrada pode receber madvise próprio
+const uint64_t kAlignment = 4096;
+
+struct ArchiveEntry {
+  uint64_t offset = 0;
+  uint64_t size = 0;
+};
+
+// Arquivo montado. Só é alterado em Mount/Unmount, que não podem correr
+// com descodificações em curso (montar antes de carregar, desmontar depois
+// de StopTextureStreaming e das recargas); por isso as consultas dos
+// workers não precisam de mutex
+MappedFile gArchive;
+std::unordered_map<std::string, ArchiveEntry> gEntries;
+
+// Forma única de um caminho relativo ("./a/../b" -> "b")
+std::string NormalizePath(const std::string &path) {
+  return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+const ArchiveEntry *FindEntry(const std::string &path) {
+  if (gEntries.empty()) {
+    return nullptr;
+  }
+  auto it = gEntries.find(NormalizePath(path));
+  return it == gEntries.end() ? nullptr : &it->second;
+}
+}
+
+bool MountAssetArchive(const std::string &path) {
+  UnmountAssetArchive();
+  MappedFile file;
+  if (!MapFile(path, file)) {
+    return false;
+  }
+  // Acesso aleatório entre entradas: desfaz o MADV_SEQUENTIAL do MapFile
+  if (file.data) {
+    madvise(const_cast<char *>(file.data), file.size, MADV_NORMAL);
+  }
+
+  // Cabeçalho e índice
+  CacheReader reader{file.data, file.data + file.size};
+  char magic[4];
+  uint32_t version = 0;
+  uint32_t entryCount = 0;
+  uint64_t indexOffset = 0;
+  bool ok = reader.Bytes(magic, sizeof(magic)) &&
+            std::memcmp(magic, kMagic, sizeof(magic)) == 0 &&
+            reader.Value(version) && version == kVersion &&
+            reader.Value(entryCount) && reader.Value(indexOffset) &&
+            indexOffset <= file.size;
+  std::unordered_map<std::string, ArchiveEntry> entries;
+  if (ok) {
+    reader.cur = file.data + indexOffset;
+  }
+  for (uint32_t i = 0; ok && i < entryCount; ++i) {
+    std::string name;
+    ArchiveEntry entry;
+    ok = reader.String(name) && reader.Value(entry.offset) &&
+         reader.Value(entry.size) && entry.offset <= indexOffset &&
+         entry.size <= indexOffset - entry.offset;
+    entries[name] = entry;
+  }
+  if (!ok) {
+    std::cerr << "Arquivo de assets invalido: " << path << "\n";
+    UnmapFile(file);
+    return false;
+  }
+
+  gArchive = file;
+  gEntries = std::move(entries);
+  return true;
+}
+
+void UnmountAssetArchive() {
+  gEntries.clear();
+  UnmapFile(gArchive);
+}
+
+bool AssetInArchive(const std::string &path) {
+  return FindEntry(path) != nullptr;
+}
+
+bool OpenAsset(const std::string &path, MappedFile &file) {
+  const ArchiveEntry *entry = FindEntry(path);
+  if (!entry) {
+    return MapFile(path, file);
+  }
+
+  // Vista emprestada: sem open/read, só pede ao kernel as páginas da entrada
+  file.data = gArchive.data + entry->offset;
+  file.size = static_cast<size_t>(entry->size);
+  file.owned = false;
+  if (file.size > 0) {
+    madvise(const_cast<char *>(file.data), file.size, MADV_WILLNEED);
+  }
+  return true;
+}
+
+GLuint CreateAssetProgram(const std::string &vertexPath,
+                          const std::string &fragmentPath) {
+  MappedFile vertexFile;
+  MappedFile fragmentFile;
+  bool ok = OpenAsset(vertexPath, vertexFile) &&
+            OpenAsset(fragmentPath, fragmentFile) && vertexFile.size > 0 &&
+            fragmentFile.size > 0;
+  GLuint program = 0;
+  if (ok) {
+    program = CreateProgramFromSource(
+        std::string_view(vertexFile.data, vertexFile.size),
+        std::string_view(fragmentFile.data, fragmentFile.size), vertexPath,
+        fragmentPath);
+  } else {
+    std::cerr << "Nao foi possivel ler os shaders em " << vertexPath << " e "
+              << fragmentPath << "\n";
+  }
+  UnmapFile(vertexFile);
+  UnmapFile(fragmentFile);
+  return program;
+}
+
+bool WriteAssetArchive(const std::string &archivePath,
+                       const std::vector<std::string> &paths) {
+  // Escreve para um temporário e renomeia no fim
+  std::string tmpPath = archivePath + ".tmp";
+  std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    std::cerr << "Nao foi possivel escrever arquivo: " << archivePath << "\n";
+    return false;
+  }
+
+  // Cabeçalho provisório; o offset do índice só se sabe no fim
+  CacheWriter writer{out};
+  writer.Bytes(kMagic, sizeof(kMagic));
+  writer.Value(kVersion);
+  writer.Value(static_cast<uint32_t>(paths.size()));
+  writer.Value(uint64_t{0});
+
+  // Dados de cada ficheiro, alinhados
+  std::vector<ArchiveEntry> entries(paths.size());
+  bool ok = true;
+  for (size_t i = 0; ok && i < paths.size(); ++i) {
+    MappedFile file;
+    if (!MapFile(paths[i], file)) {
+      std::cerr << "Nao foi possivel ler: " << paths[i] << "\n";
+      ok = false;
+      break;
+    }
+    uint64_t position = static_cast<uint64_t>(out.tellp());
+    uint64_t padding = (kAlignment - position % kAlignment) % kAlignment;
+    static const char kZeros[kAlignment] = {};
+    writer.Bytes(kZeros, static_cast<size_t>(padding));
+    entries[i].offset = position + padding;
+    entries[i].size = file.size;
+    writer.Bytes(file.data, file.size);
+    UnmapFile(file);
+  }
+
+  // Índice e offset no cabeçalho
+  uint64_t indexOffset = static_cast<uint64_t>(out.tellp());
+  for (size_t i = 0; ok && i < paths.size(); ++i) {
+    writer.String(NormalizePath(paths[i]));
+    writer.Value(entries[i].offset);
+    writer.Value(entries[i].size);
+  }
+  out.seekp(sizeof(kMagic) + 2 * sizeof(uint32_t));
+  writer.Value(indexOffset);
+
+  out.close();
+  if (!ok || !out ||
+      std::rename(tmpPath.c_str(), archivePath.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    std::cerr << "Nao foi possivel escrever arquivo: " << archivePath << "\n";
+    return false;
+  }
+  return true;
+}
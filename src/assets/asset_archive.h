@@ -0,0 +1,26 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+#include "assets/mapped_file.h"
+
+// Monta o arquivo de assets (.pak) mapeado em memória; enquanto estiver
+// montado, os ficheiros lá dentro têm prioridade sobre os soltos
+bool MountAssetArchive(const std::string &path);
+// Desmonta o arquivo (as vistas devolvidas por OpenAsset deixam de valer).
+// Só sem jobs a ler assets: depois de StopTextureStreaming e das recargas
+void UnmountAssetArchive();
+// Testa se um caminho está no arquivo montado
+bool AssetInArchive(const std::string &path);
+// Abre um asset: vista sem cópia dentro do arquivo, ou mmap do ficheiro
+// solto se não estiver lá. Fechar com UnmapFile
+bool OpenAsset(const std::string &path, MappedFile &file);
+// Cria um programa a partir de shaders lidos com OpenAsset
+GLuint CreateAssetProgram(const std::string &vertexPath,
+                          const std::string &fragmentPath);
+// Escreve um arquivo com os ficheiros indicados (usado pelo pack_assets)
+bool WriteAssetArchive(const std::string &archivePath,
+                       const std::vector<std::string> &paths);
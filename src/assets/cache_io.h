@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "assets/mapped_file.h"
+
+// Leitura sequencial com verificação de limites sobre o ficheiro mapeado
+struct CacheReader {
+  const char *cur = nullptr;
+  const char *end = nullptr;
+  // Cache vindo do arquivo de assets: as origens não são revalidadas
+  bool trusted = false;
+
+  bool Bytes(void *out, size_t size) {
+    if (static_cast<size_t>(end - cur) < size) {
+      return false;
+    }
+    std::memcpy(out, cur, size);
+    cur += size;
+    return true;
+  }
+
+  template <typename T> bool Value(T &out) { return Bytes(&out, sizeof(T)); }
+
+  // Contagem (uint64) seguida dos elementos em bloco
+  template <typename T> bool Array(std::vector<T> &out) {
+    uint64_t count = 0;
+    if (!Value(count) ||
+        count > static_cast<uint64_t>(end - cur) / sizeof(T)) {
+      return false;
+    }
+    out.resize(static_cast<size_t>(count));
+    return Bytes(out.data(), out.size() * sizeof(T));
+  }
+
+  bool String(std::string &out) {
+    uint32_t length = 0;
+    if (!Value(length) || static_cast<size_t>(end - cur) < length) {
+      return false;
+    }
+    out.assign(cur, length);
+    cur += length;
+    return true;
+  }
+};
+
+// Escrita sequencial para o ficheiro temporário do cache
+struct CacheWriter {
+  std::ofstream &out;
+
+  void Bytes(const void *data, size_t size) {
+    out.write(static_cast<const char *>(data),
+              static_cast<std::streamsize>(size));
+  }
+
+  template <typename T> void Value(const T &value) {
+    Bytes(&value, sizeof(T));
+  }
+
+  template <typename T> void Array(const std::vector<T> &values) {
+    Value(static_cast<uint64_t>(values.size()));
+    Bytes(values.data(), values.size() * sizeof(T));
+  }
+
+  void String(const std::string &value) {
+    Value(static_cast<uint32_t>(value.size()));
+    Bytes(value.data(), value.size());
+  }
+};
+
+// Grava caminho, tamanho, mtime e hash de um ficheiro de origem
+inline void WriteSourceStamp(CacheWriter &writer, const std::string &path) {
+  FileStamp stamp;
+  StatFile(path, stamp);
+  writer.String(path);
+  writer.Value(stamp.size);
+  writer.Value(stamp.mtime);
+  writer.Value(HashFile(path));
+}
+
+// Lê um registo de WriteSourceStamp e confirma que o ficheiro não mudou
+inline bool ReadSourceUnchanged(CacheReader &reader) {
+  std::string path;
+  FileStamp cached;
+  uint64_t cachedHash = 0;
+  if (!reader.String(path) || !reader.Value(cached.size) ||
+      !reader.Value(cached.mtime) || !reader.Value(cachedHash)) {
+    return false;
+  }
+  if (reader.trusted) {
+    return true;
+  }
+  FileStamp current;
+  if (!StatFile(path, current) || current.size != cached.size) {
+    return false;
+  }
+  // Mesmo mtime: confia no cache; senão compara o conteúdo
+  return current.mtime == cached.mtime || HashFile(path) == cachedHash;
+}
@@ -0,0 +1,91 @@
+#include "assets/file_watcher.h"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+namespace {
+// Forma única de um caminho ("./a/../b" -> "b")
+std::string NormalizePath(const std::filesystem::path &path) {
+  return path.lexically_normal().generic_string();
+}
+}
+
+bool StartFileWatcher(FileWatcher &watcher) {
+  StopFileWatcher(watcher);
+  watcher.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (watcher.fd < 0) {
+    std::cerr << "Nao foi possivel iniciar inotify\n";
+    return false;
+  }
+  return true;
+}
+
+bool WatchFile(FileWatcher &watcher, const std::string &path) {
+  if (watcher.fd < 0) {
+    return false;
+  }
+  std::filesystem::path file(path);
+  std::string dir = NormalizePath(file.parent_path());
+  if (dir.empty() || dir == ".") {
+    dir = ".";
+  }
+
+  // Um watch por pasta; gravações normais e substituições por rename
+  bool known = std::any_of(
+      watcher.dirs.begin(), watcher.dirs.end(),
+      [&dir](const auto &entry) { return entry.second == dir; });
+  if (!known) {
+    int wd = inotify_add_watch(watcher.fd, dir.c_str(),
+                               IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) {
+      std::cerr << "Nao foi possivel vigiar: " << dir << "\n";
+      return false;
+    }
+    watcher.dirs[wd] = dir;
+  }
+  watcher.files.insert(NormalizePath(file));
+  return true;
+}
+
+std::vector<std::string> PollChangedFiles(FileWatcher &watcher) {
+  std::vector<std::string> changed;
+  if (watcher.fd < 0) {
+    return changed;
+  }
+
+  // Lê todos os eventos pendentes (o fd é não bloqueante)
+  alignas(inotify_event) char buffer[4096];
+  while (true) {
+    ssize_t length = read(watcher.fd, buffer, sizeof(buffer));
+    if (length <= 0) {
+      break;
+    }
+    for (char *ptr = buffer; ptr < buffer + length;) {
+      const inotify_event *event = reinterpret_cast<inotify_event *>(ptr);
+      ptr += sizeof(inotify_event) + event->len;
+      auto dir = watcher.dirs.find(event->wd);
+      if (dir == watcher.dirs.end() || event->len == 0) {
+        continue;
+      }
+      // Só interessam os ficheiros registados (a pasta tem outros)
+      std::string path =
+          NormalizePath(std::filesystem::path(dir->second) / event->name);
+      if (watcher.files.count(path) &&
+          std::find(changed.begin(), changed.end(), path) == changed.end()) {
+        changed.push_back(path);
+      }
+    }
+  }
+  return changed;
+}
+
+void StopFileWatcher(FileWatcher &watcher) {
+  if (watcher.fd >= 0) {
+    close(watcher.fd);
+  }
+  watcher = FileWatcher{};
+}
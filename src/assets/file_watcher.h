@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct FileWatcher {
+  // Descritor inotify (não bloqueante); -1 se não arrancou
+  int fd = -1;
+  // Pasta de cada watch (uma por pasta, partilhada pelos ficheiros)
+  std::unordered_map<int, std::string> dirs;
+  // Ficheiros que interessam (caminho normalizado)
+  std::unordered_set<std::string> files;
+};
+
+// Cria a instância inotify
+bool StartFileWatcher(FileWatcher &watcher);
+// Passa a vigiar um ficheiro (vigia a pasta, para apanhar gravações por
+// substituição atómica como as dos editores)
+bool WatchFile(FileWatcher &watcher, const std::string &path);
+// Ficheiros vigiados que foram gravados desde a última chamada (sem
+// repetidos); nunca bloqueia
+std::vector<std::string> PollChangedFiles(FileWatcher &watcher);
+// Fecha a instância e esquece todos os watches
+void StopFileWatcher(FileWatcher &watcher);
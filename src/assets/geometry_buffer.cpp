@@ -0,0 +1,344 @@
+#include "assets/geometry_buffer.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "assets/model.h"
+#include "assets/residency.h"
+
+namespace {
+// Tamanho mínimo de cada bloco; meshes maiores têm um bloco à medida
+const size_t kBlockVertexBytes = 16 * 1024 * 1024;
+const size_t kBlockIndexBytes = 8 * 1024 * 1024;
+
+// Intervalos livres: primeiro elemento -> número de elementos
+using FreeList = std::map<uint32_t, uint32_t>;
+
+struct GeometryBlock {
+  GLuint vao = 0;
+  // Mesmo VBO/EBO com os atributos de instância (divisor 1)
+  GLuint instancedVao = 0;
+  // Byte do buffer de instâncias para onde apontam esses atributos
+  size_t instanceOffset = 0;
+  GLuint vbo = 0;
+  GLuint ebo = 0;
+  bool compact = false;
+  GLenum indexType = GL_UNSIGNED_INT;
+  // Capacidade em vértices e índices
+  uint32_t vertexCapacity = 0;
+  uint32_t indexCapacity = 0;
+  FreeList freeVertices;
+  FreeList freeIndices;
+};
+
+// Blocos vivos e VAO ligado por BindGeometry; só usados na thread de GL
+std::vector<std::unique_ptr<GeometryBlock>> gBlocks;
+GLuint gBoundVao = 0;
+// Buffer de instâncias partilhado por todos os VAOs instanciados (cresce,
+// mas o nome fica o mesmo)
+GLuint gInstanceBuffer = 0;
+size_t gInstanceCapacity = 0;
+
+size_t VertexStride(bool compact) {
+  return compact ? sizeof(CompactVertex) : sizeof(Vertex);
+}
+
+size_t IndexSize(GLenum indexType) {
+  return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+// Primeiro intervalo livre onde cabem count elementos
+bool TakeRange(FreeList &freeList, uint32_t count, uint32_t &offset) {
+  if (count == 0) {
+    offset = 0;
+    return true;
+  }
+  for (auto it = freeList.begin(); it != freeList.end(); ++it) {
+    if (it->second < count) {
+      continue;
+    }
+    offset = it->first;
+    uint32_t remaining = it->second - count;
+    freeList.erase(it);
+    if (remaining > 0) {
+      freeList[offset + count] = remaining;
+    }
+    return true;
+  }
+  return false;
+}
+
+// Devolve um intervalo, juntando-o aos vizinhos livres
+void ReturnRange(FreeList &freeList, uint32_t offset, uint32_t count) {
+  if (count == 0) {
+    return;
+  }
+  auto next = freeList.lower_bound(offset);
+  if (next != freeList.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      count += prev->second;
+      freeList.erase(prev);
+    }
+  }
+  if (next != freeList.end() && offset + count == next->first) {
+    count += next->second;
+    freeList.erase(next);
+  }
+  freeList[offset] = count;
+}
+
+bool IsEmpty(const GeometryBlock &block) {
+  auto whole = [](const FreeList &freeList, uint32_t capacity) {
+    return freeList.size() == 1 && freeList.begin()->second == capacity;
+  };
+  return whole(block.freeVertices, block.vertexCapacity) &&
+         whole(block.freeIndices, block.indexCapacity);
+}
+
+// Configura os atributos do formato de vértice do bloco no VAO ligado
+void SetupVertexFormat(bool compact) {
+  if (compact) {
+    // Posição unorm16 (relativa à AABB), normal em octaedro snorm16 e UV half
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE,
+                          sizeof(CompactVertex),
+                          (void *)(offsetof(CompactVertex, position)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(CompactVertex),
+                          (void *)(offsetof(CompactVertex, normal)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex),
+                          (void *)(offsetof(CompactVertex, texCoord)));
+    return;
+  }
+  // Posição, normal e texcoord em float
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                        (void *)(offsetof(Vertex, normal)));
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                        (void *)(offsetof(Vertex, texCoord)));
+}
+
+// Aponta os atributos de instância do VAO ligado para offset no buffer
+void SetupInstanceFormat(size_t offset) {
+  glBindBuffer(GL_ARRAY_BUFFER, gInstanceBuffer);
+  for (GLuint column = 0; column < 4; ++column) {
+    GLuint attrib = kInstanceMatrixAttrib + column;
+    glEnableVertexAttribArray(attrib);
+    glVertexAttribPointer(
+        attrib, 4, GL_FLOAT, GL_FALSE, sizeof(GpuInstance),
+        (void *)(offset + offsetof(GpuInstance, model) +
+                 column * 4 * sizeof(float)));
+    glVertexAttribDivisor(attrib, 1);
+  }
+  glEnableVertexAttribArray(kInstanceTintAttrib);
+  glVertexAttribPointer(kInstanceTintAttrib, 4, GL_FLOAT, GL_FALSE,
+                        sizeof(GpuInstance),
+                        (void *)(offset + offsetof(GpuInstance, tint)));
+  glVertexAttribDivisor(kInstanceTintAttrib, 1);
+}
+
+GeometryBlock &CreateBlock(bool compact, GLenum indexType,
+                           size_t vertexCount, size_t indexCount) {
+  auto block = std::make_unique<GeometryBlock>();
+  block->compact = compact;
+  block->indexType = indexType;
+  block->vertexCapacity = static_cast<uint32_t>(
+      std::max(vertexCount, kBlockVertexBytes / VertexStride(compact)));
+  block->indexCapacity = static_cast<uint32_t>(
+      std::max(indexCount, kBlockIndexBytes / IndexSize(indexType)));
+  block->freeVertices[0] = block->vertexCapacity;
+  block->freeIndices[0] = block->indexCapacity;
+
+  // Buffers vazios com a capacidade toda; os meshes são copiados depois
+  glGenVertexArrays(1, &block->vao);
+  glGenBuffers(1, &block->vbo);
+  glGenBuffers(1, &block->ebo);
+  glBindVertexArray(block->vao);
+  glBindBuffer(GL_ARRAY_BUFFER, block->vbo);
+  glBufferData(GL_ARRAY_BUFFER,
+               block->vertexCapacity * VertexStride(compact), nullptr,
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, block->ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+               block->indexCapacity * IndexSize(indexType), nullptr,
+               GL_STATIC_DRAW);
+  SetupVertexFormat(compact);
+
+  // Segundo VAO para os draws instanciados
+  if (!gInstanceBuffer) {
+    glGenBuffers(1, &gInstanceBuffer);
+  }
+  glGenVertexArrays(1, &block->instancedVao);
+  glBindVertexArray(block->instancedVao);
+  glBindBuffer(GL_ARRAY_BUFFER, block->vbo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, block->ebo);
+  SetupVertexFormat(compact);
+  SetupInstanceFormat(0);
+  glBindVertexArray(0);
+  gBoundVao = 0;
+  TrackGpuBuffer(block->vbo, block->vertexCapacity * VertexStride(compact),
+                 "vertices");
+  TrackGpuBuffer(block->ebo, block->indexCapacity * IndexSize(indexType),
+                 "indices");
+
+  gBlocks.push_back(std::move(block));
+  return *gBlocks.back();
+}
+
+void DeleteBlock(GeometryBlock &block) {
+  UntrackGpuBuffer(block.vbo);
+  UntrackGpuBuffer(block.ebo);
+  glDeleteBuffers(1, &block.vbo);
+  glDeleteBuffers(1, &block.ebo);
+  glDeleteVertexArrays(1, &block.vao);
+  glDeleteVertexArrays(1, &block.instancedVao);
+  if (gBoundVao == block.vao || gBoundVao == block.instancedVao) {
+    gBoundVao = 0;
+  }
+}
+}
+
+GeometryRange AllocateGeometry(bool compact, GLenum indexType,
+                               size_t vertexCount, size_t indexCount) {
+  GeometryRange range;
+  range.compact = compact;
+  range.indexType = indexType;
+  range.vertexCount = static_cast<uint32_t>(vertexCount);
+  range.indexCount = static_cast<uint32_t>(indexCount);
+
+  // Primeiro bloco compatível com espaço para vértices e índices
+  for (auto &block : gBlocks) {
+    if (block->compact != compact || block->indexType != indexType) {
+      continue;
+    }
+    if (!TakeRange(block->freeVertices, range.vertexCount, range.baseVertex)) {
+      continue;
+    }
+    if (!TakeRange(block->freeIndices, range.indexCount, range.firstIndex)) {
+      ReturnRange(block->freeVertices, range.baseVertex, range.vertexCount);
+      continue;
+    }
+    range.vao = block->vao;
+    return range;
+  }
+
+  GeometryBlock &block =
+      CreateBlock(compact, indexType, vertexCount, indexCount);
+  TakeRange(block.freeVertices, range.vertexCount, range.baseVertex);
+  TakeRange(block.freeIndices, range.indexCount, range.firstIndex);
+  range.vao = block.vao;
+  return range;
+}
+
+void UploadGeometry(const GeometryRange &range, const void *vertices,
+                    const void *indices) {
+  auto it = std::find_if(gBlocks.begin(), gBlocks.end(),
+                         [&range](const auto &block) {
+                           return block->vao == range.vao;
+                         });
+  if (it == gBlocks.end()) {
+    return;
+  }
+  // COPY_WRITE para não mexer no EBO do VAO que estiver ligado
+  const GeometryBlock &block = **it;
+  size_t stride = VertexStride(block.compact);
+  size_t indexSize = IndexSize(block.indexType);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, block.vbo);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, range.baseVertex * stride,
+                  range.vertexCount * stride, vertices);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, block.ebo);
+  glBufferSubData(GL_COPY_WRITE_BUFFER, range.firstIndex * indexSize,
+                  range.indexCount * indexSize, indices);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void FreeGeometry(GeometryRange &range) {
+  auto it = std::find_if(gBlocks.begin(), gBlocks.end(),
+                         [&range](const auto &block) {
+                           return block->vao == range.vao;
+                         });
+  if (it == gBlocks.end()) {
+    range = GeometryRange{};
+    return;
+  }
+  GeometryBlock &block = **it;
+  ReturnRange(block.freeVertices, range.baseVertex, range.vertexCount);
+  ReturnRange(block.freeIndices, range.firstIndex, range.indexCount);
+  range = GeometryRange{};
+
+  // Sem nenhum mesh: liberta a VRAM (ex.: após recarregar um modelo)
+  if (IsEmpty(block)) {
+    DeleteBlock(block);
+    gBlocks.erase(it);
+  }
+}
+
+void BindGeometry(const GeometryRange &range) {
+  if (range.vao != gBoundVao) {
+    glBindVertexArray(range.vao);
+    gBoundVao = range.vao;
+  }
+}
+
+void BindInstancedGeometry(const GeometryRange &range, size_t firstInstance) {
+  auto it = std::find_if(gBlocks.begin(), gBlocks.end(),
+                         [&range](const auto &block) {
+                           return block->vao == range.vao;
+                         });
+  if (it == gBlocks.end()) {
+    return;
+  }
+  GeometryBlock &block = **it;
+  if (block.instancedVao != gBoundVao) {
+    glBindVertexArray(block.instancedVao);
+    gBoundVao = block.instancedVao;
+  }
+  // Sem baseInstance no GL 3.3: o início é o offset dos atributos
+  size_t offset = firstInstance * sizeof(GpuInstance);
+  if (offset != block.instanceOffset) {
+    SetupInstanceFormat(offset);
+    block.instanceOffset = offset;
+  }
+}
+
+void UploadInstances(const std::vector<GpuInstance> &instances) {
+  if (!gInstanceBuffer || instances.empty()) {
+    return;
+  }
+  size_t bytes = instances.size() * sizeof(GpuInstance);
+  if (bytes > gInstanceCapacity) {
+    gInstanceCapacity = std::max(bytes, gInstanceCapacity * 2);
+    TrackGpuBuffer(gInstanceBuffer, gInstanceCapacity, "instancias");
+  }
+  // Órfão: o driver não espera pelos draws do frame anterior
+  glBindBuffer(GL_ARRAY_BUFFER, gInstanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, gInstanceCapacity, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instances.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ResetGeometryBinding() { gBoundVao = 0; }
+
+size_t GeometryBlockCount() { return gBlocks.size(); }
+
+void CleanupGeometryBuffers() {
+  for (auto &block : gBlocks) {
+    DeleteBlock(*block);
+  }
+  gBlocks.clear();
+  if (gInstanceBuffer) {
+    UntrackGpuBuffer(gInstanceBuffer);
+    glDeleteBuffers(1, &gInstanceBuffer);
+    gInstanceBuffer = 0;
+    gInstanceCapacity = 0;
+  }
+}
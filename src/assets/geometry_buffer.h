@@ -0,0 +1,58 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct GeometryRange {
+  // VAO do bloco partilhado de onde veio o espaço (0 = sem geometria)
+  GLuint vao = 0;
+  // Primeiro vértice (somado a cada índice no draw) e número de vértices
+  uint32_t baseVertex = 0;
+  uint32_t vertexCount = 0;
+  // Primeiro índice e número de índices no EBO do bloco
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+  // Tipo dos índices do bloco (16 ou 32 bits, relativos a baseVertex)
+  GLenum indexType = GL_UNSIGNED_INT;
+  // Vértices no formato CompactVertex em vez de Vertex
+  bool compact = false;
+};
+
+struct GpuInstance {
+  // Matriz do modelo (por colunas) e cor que multiplica a do material
+  float model[16];
+  float tint[4];
+};
+
+// Atributos de instância nos VAOs instanciados (a matriz ocupa 3..6)
+const GLuint kInstanceMatrixAttrib = 3;
+const GLuint kInstanceTintAttrib = 7;
+
+// Reserva espaço num bloco partilhado com o mesmo formato de vértice e de
+// índice (cria outro bloco quando nenhum tem espaço). Thread de GL
+GeometryRange AllocateGeometry(bool compact, GLenum indexType,
+                               size_t vertexCount, size_t indexCount);
+// Copia vértices e índices para o espaço reservado
+void UploadGeometry(const GeometryRange &range, const void *vertices,
+                    const void *indices);
+// Devolve o espaço ao bloco (blocos vazios são apagados)
+void FreeGeometry(GeometryRange &range);
+// Liga o VAO do bloco, sem repetir a ligação se já for o atual
+void BindGeometry(const GeometryRange &range);
+// Liga o VAO instanciado do bloco (mesmos vértices e índices mais os
+// atributos de instância), com a instância 0 a ser firstInstance no buffer
+// de instâncias
+void BindInstancedGeometry(const GeometryRange &range, size_t firstInstance);
+// Substitui o conteúdo do buffer de instâncias (uma vez por frame, antes dos
+// draws instanciados)
+void UploadInstances(const std::vector<GpuInstance> &instances);
+// Esquece o VAO ligado (chamar no início do frame: HUD e menus ligam os
+// seus próprios VAOs)
+void ResetGeometryBinding();
+// Número de blocos vivos (para diagnóstico)
+size_t GeometryBlockCount();
+// Apaga todos os blocos e o buffer de instâncias
+void CleanupGeometryBuffers();
@@ -0,0 +1,270 @@
+#include "assets/hot_reload.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#include "assets/asset_archive.h"
+#include "assets/texture_cache.h"
+#include "assets/thread_pool.h"
+
+namespace {
+// Forma única de um caminho, igual à devolvida pelo FileWatcher
+std::string NormalizePath(const std::string &path) {
+  return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+bool IsReady(const std::future<void> &future) {
+  return future.valid() && future.wait_for(std::chrono::seconds(0)) ==
+                               std::future_status::ready;
+}
+
+// Vigia o .obj, os .mtl da mesma pasta e as texturas dos materiais
+void WatchModelFiles(HotReload &reload, const WatchedModel &watched) {
+  WatchFile(reload.watcher, watched.objPath);
+  std::error_code ec;
+  std::filesystem::path dir =
+      std::filesystem::path(watched.objPath).parent_path();
+  for (const auto &entry : std::filesystem::directory_iterator(
+           dir.empty() ? "." : dir, ec)) {
+    if (entry.path().extension() == ".mtl") {
+      WatchFile(reload.watcher, entry.path().string());
+    }
+  }
+  for (const auto &entry : watched.model->materials) {
+    if (!entry.second.mapKd.empty()) {
+      WatchFile(reload.watcher, entry.second.mapKd);
+    }
+  }
+}
+
+// Faz o parse do modelo num worker (o cache .pmesh deteta a alteração)
+void StartModelLoad(WatchedModel &watched) {
+  watched.dirty = false;
+  watched.loaded = Model{};
+  WatchedModel *target = &watched;
+  watched.pending = SubmitJob(SharedThreadPool(), [target]() {
+    target->loadedOk = LoadObj(target->objPath, target->loaded);
+  });
+}
+
+// Troca o modelo antigo pelo novo (thread de GL)
+void ApplyModelLoad(HotReload &reload, WatchedModel &watched) {
+  watched.pending = {};
+  if (!watched.loadedOk) {
+    std::cerr << "Recarga falhou, a manter o modelo: " << watched.objPath
+              << "\n";
+    return;
+  }
+
+  // Materiais primeiro: as camadas do modelo antigo continuam no cache de
+  // texturas e são reaproveitadas antes de ele as largar
+  Model &loaded = watched.loaded;
+  SetupMaterials(loaded);
+  UploadModel(loaded, watched.upload);
+  CleanupModel(*watched.model);
+  *watched.model = std::move(loaded);
+  watched.loaded = Model{};
+  WatchModelFiles(reload, watched);
+  std::cout << "Modelo recarregado: " << watched.objPath << "\n";
+  if (watched.onReload) {
+    watched.onReload();
+  }
+  // Só depois do onReload, que ainda pode ler os vértices
+  if (watched.upload.gpuResident) {
+    ReleaseCpuGeometry(*watched.model);
+  }
+}
+
+// Descodifica de novo uma imagem para cada versão dela no cache
+void StartTextureReload(HotReload &reload, const std::string &path) {
+  // Camadas dos arrays, no lado atual de cada um
+  for (const CachedLayer &cached : FindCachedLayers(path)) {
+    bool useCompressed = cached.compress && GLEW_EXT_texture_compression_s3tc;
+    PendingLayer pending;
+    pending.path = path;
+    pending.texture = cached.texture;
+    pending.layer = cached.layer;
+    pending.layerSize = cached.layerSize;
+    pending.mips = std::make_unique<MipChain>();
+    MipChain *mips = pending.mips.get();
+    int layerSize = cached.layerSize;
+    pending.decoded =
+        SubmitJob(SharedThreadPool(), [path, layerSize, mips, useCompressed]() {
+          DecodeTextureLayer(path, layerSize, useCompressed, *mips);
+        });
+    reload.layers.push_back(std::move(pending));
+  }
+
+  for (bool compress : {false, true}) {
+    GLuint texture = FindCachedTexture(path, compress);
+    if (!texture) {
+      continue;
+    }
+    // Mesma escolha que o LoadTextures2D fez no carregamento
+    bool useCompressed = compress && GLEW_EXT_texture_compression_s3tc;
+    PendingTexture pending;
+    pending.path = path;
+    pending.compress = compress;
+    pending.texture = texture;
+    pending.image = std::make_unique<DecodedImage>();
+    DecodedImage *image = pending.image.get();
+    pending.decoded =
+        SubmitJob(SharedThreadPool(), [path, image, useCompressed]() {
+          if (useCompressed) {
+            DecodeCompressedImage(path, *image);
+          } else {
+            DecodeImage(path, *image);
+          }
+        });
+    reload.textures.push_back(std::move(pending));
+  }
+}
+
+// Recompila o programa; em erro mantém o anterior (thread de GL)
+void ReloadProgram(WatchedProgram &watched) {
+  GLuint program =
+      CreateAssetProgram(watched.vertexPath, watched.fragmentPath);
+  if (!program) {
+    std::cerr << "Recarga falhou, a manter o shader: " << watched.vertexPath
+              << "\n";
+    return;
+  }
+  glDeleteProgram(*watched.program);
+  *watched.program = program;
+  std::cout << "Shader recarregado: " << watched.vertexPath << "\n";
+  if (watched.onReload) {
+    watched.onReload();
+  }
+}
+}
+
+bool InitHotReload(HotReload &reload) { return StartFileWatcher(reload.watcher); }
+
+void WatchProgram(HotReload &reload, const std::string &vertexPath,
+                  const std::string &fragmentPath, GLuint &program,
+                  std::function<void()> onReload) {
+  WatchedProgram watched;
+  watched.vertexPath = vertexPath;
+  watched.fragmentPath = fragmentPath;
+  watched.program = &program;
+  watched.onReload = std::move(onReload);
+  WatchFile(reload.watcher, vertexPath);
+  WatchFile(reload.watcher, fragmentPath);
+  reload.programs.push_back(std::move(watched));
+}
+
+void WatchModel(HotReload &reload, const std::string &objPath, Model &model,
+                const ModelUploadConfig &upload,
+                std::function<void()> onReload) {
+  auto watched = std::make_unique<WatchedModel>();
+  watched->objPath = objPath;
+  watched->model = &model;
+  watched->upload = upload;
+  watched->onReload = std::move(onReload);
+  WatchModelFiles(reload, *watched);
+  reload.models.push_back(std::move(watched));
+}
+
+void UpdateHotReload(HotReload &reload) {
+  // Despacha as alterações detetadas desde o último frame
+  for (const std::string &path : PollChangedFiles(reload.watcher)) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    for (auto &program : reload.programs) {
+      if (NormalizePath(program.vertexPath) == path ||
+          NormalizePath(program.fragmentPath) == path) {
+        ReloadProgram(program);
+      }
+    }
+    bool isMesh = ext == ".obj" || ext == ".mtl";
+    std::string dir = std::filesystem::path(path).parent_path().string();
+    for (auto &model : reload.models) {
+      std::string objPath = NormalizePath(model->objPath);
+      // As imagens não refazem o modelo: só as camadas delas mudam
+      bool affected =
+          objPath == path ||
+          (ext == ".mtl" &&
+           std::filesystem::path(objPath).parent_path().string() == dir);
+      if (!affected) {
+        continue;
+      }
+      // Uma recarga de cada vez por modelo
+      if (model->pending.valid()) {
+        model->dirty = true;
+      } else {
+        StartModelLoad(*model);
+      }
+    }
+    // Texturas do cache partilhado (ex.: menus) e camadas dos arrays
+    if (!isMesh) {
+      StartTextureReload(reload, path);
+    }
+  }
+
+  // Modelos cujo parse terminou
+  for (auto &model : reload.models) {
+    if (IsReady(model->pending)) {
+      ApplyModelLoad(reload, *model);
+      if (model->dirty) {
+        StartModelLoad(*model);
+      }
+    }
+  }
+
+  // Texturas descodificadas: o conteúdo muda, o id fica (todos os
+  // materiais que a partilham veem a versão nova)
+  for (size_t i = 0; i < reload.textures.size();) {
+    PendingTexture &pending = reload.textures[i];
+    if (!IsReady(pending.decoded)) {
+      ++i;
+      continue;
+    }
+    // Se entretanto saiu do cache (ex.: modelo recarregado), já não conta
+    if (FindCachedTexture(pending.path, pending.compress) == pending.texture) {
+      UploadTexture2D(*pending.image, pending.texture);
+    }
+    FreeDecodedImage(*pending.image);
+    reload.textures.erase(reload.textures.begin() + i);
+  }
+
+  // Camadas descodificadas: só essa camada é enviada, o resto do array e os
+  // materiais ficam como estão
+  for (size_t i = 0; i < reload.layers.size();) {
+    PendingLayer &pending = reload.layers[i];
+    if (!IsReady(pending.decoded)) {
+      ++i;
+      continue;
+    }
+    // Ainda lá está com o mesmo lado (o array pode ter sido reduzido,
+    // largado ou apagado entretanto)
+    for (const CachedLayer &cached : FindCachedLayers(pending.path)) {
+      if (cached.texture != pending.texture || cached.layer != pending.layer) {
+        continue;
+      }
+      // A meio de um streaming o array ainda não tem todos os níveis: é
+      // refeito inteiro (com a imagem nova)
+      if (cached.layerSize != pending.layerSize ||
+          !UploadTextureLayer(pending.texture, pending.layer, *pending.mips)) {
+        ReloadCachedArray(pending.texture);
+      }
+    }
+    reload.layers.erase(reload.layers.begin() + i);
+  }
+}
+
+void CleanupHotReload(HotReload &reload) {
+  for (auto &model : reload.models) {
+    if (model->pending.valid()) {
+      model->pending.wait();
+    }
+  }
+  for (auto &pending : reload.textures) {
+    pending.decoded.wait();
+    FreeDecodedImage(*pending.image);
+  }
+  for (auto &pending : reload.layers) {
+    pending.decoded.wait();
+  }
+  StopFileWatcher(reload.watcher);
+  reload = HotReload{};
+}
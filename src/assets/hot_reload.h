@@ -0,0 +1,83 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "assets/file_watcher.h"
+#include "assets/model.h"
+#include "assets/texture.h"
+
+struct WatchedProgram {
+  // Shaders de origem e programa que é substituído no sítio
+  std::string vertexPath;
+  std::string fragmentPath;
+  GLuint *program = nullptr;
+  // Chamado depois da troca (para voltar a ler as localizações de uniforms)
+  std::function<void()> onReload;
+};
+
+struct WatchedModel {
+  std::string objPath;
+  Model *model = nullptr;
+  // Formato de vértice e residência usados no upload original
+  ModelUploadConfig upload;
+  // Chamado depois da troca (ex.: refazer a colisão da estrada)
+  std::function<void()> onReload;
+  // Recarga em curso no pool de threads
+  std::future<void> pending;
+  Model loaded;
+  bool loadedOk = false;
+  // Houve nova alteração durante a recarga: repete no fim
+  bool dirty = false;
+};
+
+struct PendingTexture {
+  // Textura do cache cujo conteúdo vai ser substituído
+  std::string path;
+  bool compress = false;
+  GLuint texture = 0;
+  std::unique_ptr<DecodedImage> image;
+  std::future<void> decoded;
+};
+
+struct PendingLayer {
+  // Camada de um array do cache que vai ser substituída (lado da altura do
+  // pedido: se mudar entretanto, a versão descodificada já não serve)
+  std::string path;
+  GLuint texture = 0;
+  int layer = 0;
+  int layerSize = 0;
+  std::unique_ptr<MipChain> mips;
+  std::future<void> decoded;
+};
+
+struct HotReload {
+  FileWatcher watcher;
+  std::vector<WatchedProgram> programs;
+  // unique_ptr: as tarefas no pool guardam ponteiros para estes objetos
+  std::vector<std::unique_ptr<WatchedModel>> models;
+  std::vector<PendingTexture> textures;
+  std::vector<PendingLayer> layers;
+};
+
+// Arranca o vigia de ficheiros
+bool InitHotReload(HotReload &reload);
+// Recompila o programa quando um dos shaders muda
+void WatchProgram(HotReload &reload, const std::string &vertexPath,
+                  const std::string &fragmentPath, GLuint &program,
+                  std::function<void()> onReload = {});
+// Recarrega o modelo quando o .obj/.mtl muda; uma imagem alterada só
+// substitui as camadas dos arrays onde está
+void WatchModel(HotReload &reload, const std::string &objPath, Model &model,
+                const ModelUploadConfig &upload,
+                std::function<void()> onReload = {});
+// Chamar uma vez por frame na thread de GL: lê alterações, lança
+// descodificações/parses no pool e aplica os que já terminaram
+void UpdateHotReload(HotReload &reload);
+// Espera pelas tarefas em curso e fecha o vigia
+void CleanupHotReload(HotReload &reload);
@@ -0,0 +1,82 @@
+#include "assets/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MapFile(const std::string &path, MappedFile &file) {
+  // Abre o ficheiro e descobre o tamanho
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+
+  // Ficheiro vazio: nada para mapear mas não é erro
+  file.data = nullptr;
+  file.owned = false;
+  file.size = static_cast<size_t>(st.st_size);
+  if (file.size == 0) {
+    close(fd);
+    return true;
+  }
+
+  // Mapeia o ficheiro; o descritor pode ser fechado logo a seguir
+  void *ptr = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (ptr == MAP_FAILED) {
+    file.size = 0;
+    return false;
+  }
+
+  // Leitura sequencial: pede ao kernel para fazer read-ahead agressivo
+  madvise(ptr, file.size, MADV_SEQUENTIAL);
+  file.data = static_cast<const char *>(ptr);
+  file.owned = true;
+  return true;
+}
+
+void UnmapFile(MappedFile &file) {
+  // Liberta o mapeamento (vistas emprestadas não são nossas)
+  if (file.data && file.owned) {
+    munmap(const_cast<char *>(file.data), file.size);
+  }
+  file = MappedFile{};
+}
+
+uint64_t HashBytes(const void *data, size_t size) {
+  // FNV-1a: simples e suficiente para detetar alterações de conteúdo
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  uint64_t hash = 1469598103934665603ull;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+bool StatFile(const std::string &path, FileStamp &stamp) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return false;
+  }
+  stamp.size = static_cast<uint64_t>(st.st_size);
+  stamp.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 +
+                st.st_mtim.tv_nsec;
+  return true;
+}
+
+uint64_t HashFile(const std::string &path) {
+  MappedFile file;
+  if (!MapFile(path, file)) {
+    return 0;
+  }
+  uint64_t hash = HashBytes(file.data, file.size);
+  UnmapFile(file);
+  return hash;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct MappedFile {
+  // Início dos bytes mapeados (só leitura)
+  const char *data = nullptr;
+  // Tamanho do ficheiro em bytes
+  size_t size = 0;
+  // false para vistas emprestadas (ex.: dentro do arquivo de assets)
+  bool owned = false;
+};
+
+// Mapeia um ficheiro inteiro em memória (mmap, só leitura)
+bool MapFile(const std::string &path, MappedFile &file);
+// Desfaz o mapeamento criado por MapFile
+void UnmapFile(MappedFile &file);
+struct FileStamp {
+  // Tamanho e data de modificação (ns) de um ficheiro
+  uint64_t size = 0;
+  int64_t mtime = 0;
+};
+
+// Hash FNV-1a de 64 bits de um bloco de memória (para validar caches)
+uint64_t HashBytes(const void *data, size_t size);
+// Lê tamanho e mtime de um ficheiro
+bool StatFile(const std::string &path, FileStamp &stamp);
+// Hash do conteúdo de um ficheiro (0 se não existir)
+uint64_t HashFile(const std::string &path);
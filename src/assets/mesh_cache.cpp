@@ -0,0 +1,189 @@
+#include "assets/mesh_cache.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "assets/asset_archive.h"
+#include "assets/cache_io.h"
+
+namespace {
+// Identificação e versão do formato; mudar a versão invalida caches antigos
+const char kMagic[4] = {'P', 'M', 'S', 'H'};
+const uint32_t kVersion = 7;
+
+// Verifica se os ficheiros de origem não mudaram desde que o cache foi feito
+bool SourcesUnchanged(CacheReader &reader) {
+  uint32_t sourceCount = 0;
+  if (!reader.Value(sourceCount)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < sourceCount; ++i) {
+    if (!ReadSourceUnchanged(reader)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Opções do loader que mudam os meshes guardados (reordenação, LODs e
+// divisão em clusters)
+void WriteLoadSettings(CacheWriter &writer, const ObjLoadConfig &config) {
+  writer.Value(static_cast<uint8_t>(config.optimizeMeshes));
+  writer.Value(static_cast<uint8_t>(config.generateLods));
+  writer.Value(static_cast<uint64_t>(config.clusterTriangles));
+}
+
+bool SameLoadSettings(CacheReader &reader, const ObjLoadConfig &config) {
+  uint8_t optimizeMeshes = 0;
+  uint8_t generateLods = 0;
+  uint64_t clusterTriangles = 0;
+  return reader.Value(optimizeMeshes) &&
+         optimizeMeshes == static_cast<uint8_t>(config.optimizeMeshes) &&
+         reader.Value(generateLods) &&
+         generateLods == static_cast<uint8_t>(config.generateLods) &&
+         reader.Value(clusterTriangles) &&
+         clusterTriangles == static_cast<uint64_t>(config.clusterTriangles);
+}
+}
+
+std::string MeshCachePath(const std::string &objPath) {
+  // Troca a extensão do OBJ por .pmesh
+  size_t slash = objPath.find_last_of("/\\");
+  size_t dot = objPath.find_last_of('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+    return objPath + ".pmesh";
+  }
+  return objPath.substr(0, dot) + ".pmesh";
+}
+
+bool LoadMeshCache(const std::string &objPath, const ObjLoadConfig &config,
+                   Model &model) {
+  // Mapeia o cache; se não existir simplesmente não há cache
+  std::string cachePath = MeshCachePath(objPath);
+  MappedFile file;
+  if (!OpenAsset(cachePath, file)) {
+    return false;
+  }
+
+  CacheReader reader{file.data, file.data + file.size,
+                     AssetInArchive(cachePath)};
+  char magic[4];
+  uint32_t version = 0;
+  uint32_t vertexSize = 0;
+  bool ok = reader.Bytes(magic, sizeof(magic)) &&
+            std::memcmp(magic, kMagic, sizeof(magic)) == 0 &&
+            reader.Value(version) && version == kVersion &&
+            reader.Value(vertexSize) && vertexSize == sizeof(Vertex) &&
+            SameLoadSettings(reader, config) && SourcesUnchanged(reader);
+
+  // Transformação de centro/escala já aplicada aos vértices
+  Model loaded;
+  uint32_t materialCount = 0;
+  uint32_t meshCount = 0;
+  ok = ok && reader.Value(loaded.center) && reader.Value(loaded.scale) &&
+       reader.Value(loaded.minY) && reader.Value(loaded.boundsMin) &&
+       reader.Value(loaded.boundsMax) && reader.Value(materialCount) &&
+       reader.Value(meshCount);
+
+  // Materiais
+  for (uint32_t i = 0; ok && i < materialCount; ++i) {
+    Material material;
+    ok = reader.String(material.name) && reader.Value(material.kd) &&
+         reader.String(material.mapKd);
+    if (ok) {
+      std::string name = material.name;
+      loaded.materials[name] = std::move(material);
+    }
+  }
+
+  // Meshes: vértices e índices são copiados em bloco do ficheiro mapeado
+  loaded.meshes.reserve(meshCount);
+  for (uint32_t i = 0; ok && i < meshCount; ++i) {
+    Mesh mesh;
+    ok = reader.String(mesh.materialName) && reader.Array(mesh.vertices) &&
+         reader.Array(mesh.indices) && reader.Array(mesh.lodIndices) &&
+         reader.Array(mesh.lods) && reader.Value(mesh.boundsMin) &&
+         reader.Value(mesh.boundsMax) && reader.Value(mesh.boundsCenter) &&
+         reader.Value(mesh.boundsRadius);
+    if (ok) {
+      loaded.meshes.push_back(std::move(mesh));
+    }
+  }
+  UnmapFile(file);
+  if (!ok) {
+    return false;
+  }
+
+  // Só altera o modelo quando o cache foi lido por inteiro (substitui os
+  // meshes, tal como o parse)
+  model.meshes = std::move(loaded.meshes);
+  model.materials = std::move(loaded.materials);
+  model.center = loaded.center;
+  model.scale = loaded.scale;
+  model.minY = loaded.minY;
+  model.boundsMin = loaded.boundsMin;
+  model.boundsMax = loaded.boundsMax;
+  return true;
+}
+
+bool SaveMeshCache(const std::string &objPath,
+                   const std::vector<std::string> &sources,
+                   const ObjLoadConfig &config, const Model &model) {
+  // Escreve para um temporário e renomeia no fim (nunca fica meio escrito)
+  std::string cachePath = MeshCachePath(objPath);
+  std::string tmpPath = cachePath + ".tmp";
+  std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    std::cerr << "Nao foi possivel escrever cache: " << cachePath << "\n";
+    return false;
+  }
+
+  CacheWriter writer{out};
+  writer.Bytes(kMagic, sizeof(kMagic));
+  writer.Value(kVersion);
+  writer.Value(static_cast<uint32_t>(sizeof(Vertex)));
+  WriteLoadSettings(writer, config);
+
+  // Ficheiros de origem com tamanho, mtime e hash do conteúdo
+  writer.Value(static_cast<uint32_t>(sources.size()));
+  for (const auto &source : sources) {
+    WriteSourceStamp(writer, source);
+  }
+
+  writer.Value(model.center);
+  writer.Value(model.scale);
+  writer.Value(model.minY);
+  writer.Value(model.boundsMin);
+  writer.Value(model.boundsMax);
+  writer.Value(static_cast<uint32_t>(model.materials.size()));
+  writer.Value(static_cast<uint32_t>(model.meshes.size()));
+
+  for (const auto &entry : model.materials) {
+    writer.String(entry.second.name);
+    writer.Value(entry.second.kd);
+    writer.String(entry.second.mapKd);
+  }
+
+  for (const auto &mesh : model.meshes) {
+    writer.String(mesh.materialName);
+    writer.Array(mesh.vertices);
+    writer.Array(mesh.indices);
+    writer.Array(mesh.lodIndices);
+    writer.Array(mesh.lods);
+    writer.Value(mesh.boundsMin);
+    writer.Value(mesh.boundsMax);
+    writer.Value(mesh.boundsCenter);
+    writer.Value(mesh.boundsRadius);
+  }
+
+  out.close();
+  if (!out || std::rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    std::cerr << "Nao foi possivel escrever cache: " << cachePath << "\n";
+    return false;
+  }
+  return true;
+}
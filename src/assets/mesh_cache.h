@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "assets/model.h"
+
+// Caminho do cache binário associado a um OBJ (pista.obj -> pista.pmesh)
+std::string MeshCachePath(const std::string &objPath);
+// Carrega o modelo já processado do cache (.pmesh) se ainda for válido e
+// tiver sido gerado com as mesmas opções de processamento de config
+bool LoadMeshCache(const std::string &objPath, const ObjLoadConfig &config,
+                   Model &model);
+// Guarda o modelo processado; sources = ficheiros .obj/.mtl que o geraram
+bool SaveMeshCache(const std::string &objPath,
+                   const std::vector<std::string> &sources,
+                   const ObjLoadConfig &config, const Model &model);
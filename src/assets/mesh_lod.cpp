@@ -0,0 +1,407 @@
+#include "assets/mesh_lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "assets/mesh_optimize.h"
+
+namespace {
+// Matriz 4x4 simétrica da quádrica (10 coeficientes)
+struct Quadric {
+  double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+  double a11 = 0, a12 = 0, a13 = 0;
+  double a22 = 0, a23 = 0;
+  double a33 = 0;
+  // Soma dos pesos, para o erro ser uma média de distâncias²
+  double w = 0;
+};
+
+void AddQuadric(Quadric &q, const Quadric &o) {
+  q.a00 += o.a00;
+  q.a01 += o.a01;
+  q.a02 += o.a02;
+  q.a03 += o.a03;
+  q.a11 += o.a11;
+  q.a12 += o.a12;
+  q.a13 += o.a13;
+  q.a22 += o.a22;
+  q.a23 += o.a23;
+  q.a33 += o.a33;
+  q.w += o.w;
+}
+
+// Quádrica do plano n.p + d = 0 (n unitário) com peso w
+Quadric PlaneQuadric(const Vec3 &n, float d, double w) {
+  Quadric q;
+  q.a00 = w * n.x * n.x;
+  q.a01 = w * n.x * n.y;
+  q.a02 = w * n.x * n.z;
+  q.a03 = w * n.x * d;
+  q.a11 = w * n.y * n.y;
+  q.a12 = w * n.y * n.z;
+  q.a13 = w * n.y * d;
+  q.a22 = w * n.z * n.z;
+  q.a23 = w * n.z * d;
+  q.a33 = w * double(d) * d;
+  q.w = w;
+  return q;
+}
+
+// Média ponderada das distâncias² de p aos planos da quádrica
+double QuadricError(const Quadric &q, const Vec3 &p) {
+  if (q.w <= 0.0) {
+    return 0.0;
+  }
+  double x = p.x, y = p.y, z = p.z;
+  double e = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z + q.a33 +
+             2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z +
+                    q.a03 * x + q.a13 * y + q.a23 * z);
+  return std::max(e, 0.0) / q.w;
+}
+
+enum class VertexKind : uint8_t {
+  Manifold, // interior: pode colapsar para qualquer vizinho
+  Border,   // borda aberta: só colapsa ao longo da borda
+  Locked,   // costura ou topologia estranha: nunca se move
+};
+
+uint64_t EdgeKey(uint32_t a, uint32_t b) {
+  return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+struct Collapse {
+  uint32_t from = 0;
+  uint32_t to = 0;
+  double cost = 0.0;
+};
+
+// Normal não normalizada (comprimento = 2 x área)
+Vec3 TriangleNormal(const Vec3 &a, const Vec3 &b, const Vec3 &c) {
+  return Cross(b - a, c - a);
+}
+}
+
+std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex> &vertices,
+                                   const std::vector<uint32_t> &indices,
+                                   size_t targetIndexCount, float &outError) {
+  outError = 0.0f;
+  std::vector<uint32_t> result = indices;
+  size_t vertexCount = vertices.size();
+  if (result.size() <= targetIndexCount || vertexCount == 0) {
+    return result;
+  }
+
+  // Vértices com a mesma posição (costuras de UV/normal) partilham um id:
+  // ordenados pela posição, cada grupo igual aponta para o menor índice
+  std::vector<uint32_t> position(vertexCount);
+  std::vector<uint32_t> wedges(vertexCount, 0);
+  {
+    std::vector<uint32_t> order(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+      order[v] = v;
+    }
+    auto samePosition = [&](uint32_t a, uint32_t b) {
+      return std::memcmp(&vertices[a].position, &vertices[b].position,
+                         sizeof(Vec3)) == 0;
+    };
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+      int c = std::memcmp(&vertices[a].position, &vertices[b].position,
+                          sizeof(Vec3));
+      return c != 0 ? c < 0 : a < b;
+    });
+    for (size_t i = 0; i < vertexCount; ++i) {
+      uint32_t v = order[i];
+      bool first = i == 0 || !samePosition(order[i - 1], v);
+      position[v] = first ? v : position[order[i - 1]];
+      ++wedges[position[v]];
+    }
+  }
+
+  // Arestas de borda (sem a aresta oposta) no espaço das posições, em
+  // arrays ordenados de chaves (procura binária)
+  std::vector<uint64_t> directed;
+  directed.reserve(result.size());
+  for (size_t i = 0; i < result.size(); i += 3) {
+    for (int e = 0; e < 3; ++e) {
+      uint32_t a = position[result[i + e]];
+      uint32_t b = position[result[i + (e + 1) % 3]];
+      directed.push_back(EdgeKey(a, b));
+    }
+  }
+  std::sort(directed.begin(), directed.end());
+  directed.erase(std::unique(directed.begin(), directed.end()),
+                 directed.end());
+  std::vector<uint64_t> borderEdges;
+  std::vector<uint32_t> borderCount(vertexCount, 0);
+  for (uint64_t key : directed) {
+    uint32_t a = static_cast<uint32_t>(key >> 32);
+    uint32_t b = static_cast<uint32_t>(key & 0xffffffffu);
+    if (!std::binary_search(directed.begin(), directed.end(),
+                            EdgeKey(b, a))) {
+      borderEdges.push_back(EdgeKey(std::min(a, b), std::max(a, b)));
+      ++borderCount[a];
+      ++borderCount[b];
+    }
+  }
+  std::sort(borderEdges.begin(), borderEdges.end());
+  std::vector<VertexKind> kind(vertexCount, VertexKind::Manifold);
+  for (uint32_t v = 0; v < vertexCount; ++v) {
+    uint32_t p = position[v];
+    if (wedges[p] > 1) {
+      kind[v] = VertexKind::Locked;
+    } else if (borderCount[p] == 2) {
+      kind[v] = VertexKind::Border;
+    } else if (borderCount[p] != 0) {
+      kind[v] = VertexKind::Locked;
+    }
+  }
+  auto isBorderEdge = [&](uint32_t a, uint32_t b) {
+    uint32_t pa = position[a];
+    uint32_t pb = position[b];
+    return std::binary_search(borderEdges.begin(), borderEdges.end(),
+                              EdgeKey(std::min(pa, pb), std::max(pa, pb)));
+  };
+
+  // Quádricas: planos dos triângulos (peso = área) e planos perpendiculares
+  // às arestas de borda, para a silhueta aberta não encolher
+  std::vector<Quadric> quadrics(vertexCount);
+  for (size_t i = 0; i < result.size(); i += 3) {
+    const Vec3 &p0 = vertices[result[i]].position;
+    const Vec3 &p1 = vertices[result[i + 1]].position;
+    const Vec3 &p2 = vertices[result[i + 2]].position;
+    Vec3 normal = TriangleNormal(p0, p1, p2);
+    float area = Length(normal);
+    if (area <= 0.0f) {
+      continue;
+    }
+    normal = normal / area;
+    Quadric plane = PlaneQuadric(normal, -Dot(normal, p0), area * 0.5);
+    const Vec3 *corners[3] = {&p0, &p1, &p2};
+    for (int e = 0; e < 3; ++e) {
+      uint32_t a = result[i + e];
+      uint32_t b = result[i + (e + 1) % 3];
+      AddQuadric(quadrics[a], plane);
+      if (!isBorderEdge(a, b)) {
+        continue;
+      }
+      Vec3 edge = *corners[(e + 1) % 3] - *corners[e];
+      float length = Length(edge);
+      if (length <= 0.0f) {
+        continue;
+      }
+      Vec3 side = Normalize(Cross(edge, normal));
+      Quadric border =
+          PlaneQuadric(side, -Dot(side, *corners[e]), 10.0 * length * length);
+      AddQuadric(quadrics[a], border);
+      AddQuadric(quadrics[b], border);
+    }
+  }
+
+  // Passagens: colapsa as arestas mais baratas sem tocar duas vezes no mesmo
+  // vértice; repete até ao alvo ou até não haver colapsos válidos
+  double maxCost = 0.0;
+  std::vector<uint32_t> remap(vertexCount);
+  std::vector<uint8_t> touched(vertexCount);
+  std::vector<uint32_t> adjacencyStart(vertexCount + 1);
+  std::vector<uint32_t> adjacency;
+  while (result.size() > targetIndexCount) {
+    size_t triangleCount = result.size() / 3;
+
+    // Adjacência vértice -> triângulos (CSR)
+    std::fill(adjacencyStart.begin(), adjacencyStart.end(), 0);
+    for (uint32_t index : result) {
+      ++adjacencyStart[index + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+      adjacencyStart[v + 1] += adjacencyStart[v];
+    }
+    adjacency.resize(result.size());
+    std::vector<uint32_t> fill(adjacencyStart.begin(),
+                               adjacencyStart.end() - 1);
+    for (size_t i = 0; i < result.size(); ++i) {
+      adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    // Candidatos e respetivos custos
+    std::vector<Collapse> candidates;
+    candidates.reserve(result.size());
+    for (size_t i = 0; i < result.size(); i += 3) {
+      for (int e = 0; e < 3; ++e) {
+        uint32_t a = result[i + e];
+        uint32_t b = result[i + (e + 1) % 3];
+        for (int dir = 0; dir < 2; ++dir) {
+          uint32_t from = dir ? b : a;
+          uint32_t to = dir ? a : b;
+          bool allowed =
+              kind[from] == VertexKind::Manifold ||
+              (kind[from] == VertexKind::Border &&
+               kind[to] != VertexKind::Manifold && isBorderEdge(from, to));
+          if (!allowed) {
+            continue;
+          }
+          Quadric q = quadrics[from];
+          AddQuadric(q, quadrics[to]);
+          candidates.push_back({from, to,
+                                QuadricError(q, vertices[to].position)});
+        }
+      }
+    }
+    if (candidates.empty()) {
+      break;
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Collapse &x, const Collapse &y) {
+                return x.cost < y.cost;
+              });
+
+    // Aplica por ordem de custo; cada colapso remove ~2 triângulos
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+      remap[v] = v;
+    }
+    std::fill(touched.begin(), touched.end(), 0);
+    size_t removable = triangleCount - targetIndexCount / 3;
+    size_t removed = 0;
+    for (const Collapse &collapse : candidates) {
+      if (removed >= removable) {
+        break;
+      }
+      if (touched[collapse.from] || touched[collapse.to]) {
+        continue;
+      }
+
+      // Rejeita se algum triângulo à volta de "from" se virar ao contrário
+      const Vec3 &target = vertices[collapse.to].position;
+      bool flips = false;
+      size_t collapsing = 0;
+      for (uint32_t k = adjacencyStart[collapse.from];
+           k < adjacencyStart[collapse.from + 1] && !flips; ++k) {
+        const uint32_t *tri = &result[adjacency[k] * 3];
+        if (tri[0] == collapse.to || tri[1] == collapse.to ||
+            tri[2] == collapse.to) {
+          ++collapsing;
+          continue;
+        }
+        Vec3 p[3];
+        Vec3 q[3];
+        for (int c = 0; c < 3; ++c) {
+          p[c] = vertices[tri[c]].position;
+          q[c] = tri[c] == collapse.from ? target : p[c];
+        }
+        Vec3 before = TriangleNormal(p[0], p[1], p[2]);
+        Vec3 after = TriangleNormal(q[0], q[1], q[2]);
+        flips = Dot(before, after) <= 0.0f;
+      }
+      if (flips) {
+        continue;
+      }
+
+      remap[collapse.from] = collapse.to;
+      AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+      touched[collapse.from] = 1;
+      touched[collapse.to] = 1;
+      maxCost = std::max(maxCost, collapse.cost);
+      removed += collapsing;
+    }
+    if (removed == 0) {
+      break;
+    }
+
+    // Reescreve os índices e descarta triângulos degenerados
+    size_t out = 0;
+    for (size_t i = 0; i < result.size(); i += 3) {
+      uint32_t a = remap[result[i]];
+      uint32_t b = remap[result[i + 1]];
+      uint32_t c = remap[result[i + 2]];
+      if (a == b || b == c || c == a) {
+        continue;
+      }
+      result[out++] = a;
+      result[out++] = b;
+      result[out++] = c;
+    }
+    result.resize(out);
+  }
+
+  outError = static_cast<float>(std::sqrt(maxCost));
+  return result;
+}
+
+void GenerateMeshLods(Mesh &mesh, const LodConfig &config) {
+  // Nível 0 = índices originais; os seguintes vão para lodIndices
+  mesh.lods.clear();
+  mesh.lodIndices.clear();
+  MeshLod full;
+  full.indexCount = static_cast<uint32_t>(mesh.indices.size());
+  mesh.lods.push_back(full);
+
+  std::vector<uint32_t> previous = mesh.indices;
+  float previousError = 0.0f;
+  for (unsigned level = 1; level <= config.levelCount; ++level) {
+    size_t target =
+        static_cast<size_t>(previous.size() * config.levelRatio) / 3 * 3;
+    float error = 0.0f;
+    std::vector<uint32_t> simplified =
+        SimplifyMesh(mesh.vertices, previous, target, error);
+    // Pouca redução (vértices presos em costuras): não vale um nível
+    if (simplified.size() < 3 ||
+        simplified.size() >
+            previous.size() * (1.0f - config.minReduction)) {
+      break;
+    }
+    MeshLod lod;
+    lod.indexOffset =
+        static_cast<uint32_t>(mesh.indices.size() + mesh.lodIndices.size());
+    lod.indexCount = static_cast<uint32_t>(simplified.size());
+    // Os erros acumulam-se de nível para nível
+    lod.error = previousError + error;
+    std::vector<uint32_t> ordered =
+        OptimizeVertexCache(simplified, mesh.vertices.size());
+    mesh.lodIndices.insert(mesh.lodIndices.end(), ordered.begin(),
+                           ordered.end());
+    mesh.lods.push_back(lod);
+    previous = std::move(simplified);
+    previousError = lod.error;
+  }
+}
+
+void SelectLods(const Model &model, const Mat4 &modelMatrix, const Vec3 &eye,
+                float pixelsPerUnit, LodState &state,
+                const LodSelectConfig &config) {
+  state.levels.resize(model.meshes.size(), 0);
+  // Escala uniforme da matriz (comprimento da primeira coluna)
+  const float *m = modelMatrix.m;
+  float scale = std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+
+  for (size_t i = 0; i < model.meshes.size(); ++i) {
+    const Mesh &mesh = model.meshes[i];
+    size_t levelCount = mesh.lods.size();
+    if (levelCount <= 1) {
+      state.levels[i] = 0;
+      continue;
+    }
+
+    // Distância da câmara à superfície da esfera, em unidades de mundo
+    const Vec3 &c = mesh.boundsCenter;
+    Vec3 center = {m[0] * c.x + m[4] * c.y + m[8] * c.z + m[12],
+                   m[1] * c.x + m[5] * c.y + m[9] * c.z + m[13],
+                   m[2] * c.x + m[6] * c.y + m[10] * c.z + m[14]};
+    float distance = Length(center - eye) - mesh.boundsRadius * scale;
+    float perUnit = pixelsPerUnit / std::max(distance, 0.01f);
+    auto screenError = [&](size_t level) {
+      return mesh.lods[level].error * scale * perUnit;
+    };
+
+    // Sobe de detalhe se o nível atual já se nota; só desce com folga
+    size_t level = std::min<size_t>(state.levels[i], levelCount - 1);
+    while (level > 0 && screenError(level) > config.pixelError) {
+      --level;
+    }
+    while (level + 1 < levelCount &&
+           screenError(level + 1) <=
+               config.pixelError * (1.0f - config.hysteresis)) {
+      ++level;
+    }
+    state.levels[i] = static_cast<uint8_t>(level);
+  }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "assets/model.h"
+#include "math.h"
+
+struct LodConfig {
+  // Níveis extra além do original e fração de triângulos de cada um
+  unsigned levelCount = 3;
+  float levelRatio = 0.5f;
+  // Um nível que não reduz pelo menos isto face ao anterior não é guardado
+  float minReduction = 0.2f;
+};
+
+struct LodSelectConfig {
+  // Erro máximo aceite no ecrã, em pixels
+  float pixelError = 1.0f;
+  // Banda de histerese: só desce de detalhe com folga desta fração
+  float hysteresis = 0.3f;
+};
+
+struct LodState {
+  // Nível atual de cada mesh de uma instância do modelo
+  std::vector<uint8_t> levels;
+};
+
+// Simplifica por colapso de arestas com erro quadrático (Garland-Heckbert)
+// sem criar vértices: devolve novos índices para os mesmos vértices.
+// Vértices em costuras (mesma posição, atributos diferentes) ficam fixos e
+// os das bordas só deslizam ao longo da borda. outError = distância máxima
+std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex> &vertices,
+                                   const std::vector<uint32_t> &indices,
+                                   size_t targetIndexCount, float &outError);
+// Gera os níveis de LOD do mesh
+void GenerateMeshLods(Mesh &mesh, const LodConfig &config = {});
+// Escolhe o nível de cada mesh pelo erro projetado no ecrã.
+// pixelsPerUnit = altura do viewport / (2 * tan(fov / 2))
+void SelectLods(const Model &model, const Mat4 &modelMatrix, const Vec3 &eye,
+                float pixelsPerUnit, LodState &state,
+                const LodSelectConfig &config = {});
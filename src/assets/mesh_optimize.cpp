@@ -0,0 +1,302 @@
+#include "assets/mesh_optimize.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace {
+// Tamanho de cache assumido pelo Tipsify (conservador para GPUs atuais)
+const unsigned kCacheSize = 16;
+// Um cluster só é cortado se o ACMR local não piorar mais que isto
+const float kOverdrawThreshold = 1.05f;
+
+// Cache FIFO simulada: um vértice está na cache se entrou há menos de
+// cacheSize falhas
+struct FifoCache {
+  std::vector<uint32_t> stamps;
+  uint32_t time;
+  unsigned size;
+
+  FifoCache(size_t vertexCount, unsigned cacheSize)
+      : stamps(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+  // Devolve o número de falhas ao processar um triângulo
+  unsigned Triangle(const uint32_t *tri) {
+    unsigned misses = 0;
+    for (int k = 0; k < 3; ++k) {
+      if (time - stamps[tri[k]] > size) {
+        stamps[tri[k]] = time++;
+        ++misses;
+      }
+    }
+    return misses;
+  }
+
+  // Esvazia a cache sem percorrer os vértices
+  void Reset() { time += size + 1; }
+};
+
+// Próximo vértice quando o leque atual termina: pilha de vértices recentes,
+// depois varrimento sequencial
+int64_t SkipDeadEnd(std::vector<uint32_t> &deadEnd,
+                    const std::vector<uint32_t> &live, size_t &cursor) {
+  while (!deadEnd.empty()) {
+    uint32_t vertex = deadEnd.back();
+    deadEnd.pop_back();
+    if (live[vertex] > 0) {
+      return vertex;
+    }
+  }
+  for (; cursor < live.size(); ++cursor) {
+    if (live[cursor] > 0) {
+      return static_cast<int64_t>(cursor);
+    }
+  }
+  return -1;
+}
+
+// Tipsify (Sander, Nehab e Barczak 2007): ordena os triângulos em leques à
+// volta de vértices na cache. Devolve também as fronteiras duras (triângulo
+// onde o algoritmo teve de saltar para longe)
+std::vector<uint32_t> Tipsify(const std::vector<uint32_t> &indices,
+                              size_t vertexCount,
+                              std::vector<size_t> &hardBoundaries) {
+  size_t triangleCount = indices.size() / 3;
+
+  // Adjacência vértice -> triângulos em formato CSR
+  std::vector<uint32_t> live(vertexCount, 0);
+  for (uint32_t index : indices) {
+    ++live[index];
+  }
+  std::vector<size_t> offsets(vertexCount + 1, 0);
+  for (size_t v = 0; v < vertexCount; ++v) {
+    offsets[v + 1] = offsets[v] + live[v];
+  }
+  std::vector<uint32_t> adjacency(indices.size());
+  std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+
+  std::vector<uint32_t> cacheTime(vertexCount, 0);
+  std::vector<char> emitted(triangleCount, 0);
+  std::vector<uint32_t> deadEnd;
+  std::vector<uint32_t> candidates;
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+  uint32_t time = kCacheSize + 1;
+  size_t cursor = 0;
+
+  int64_t fanning = SkipDeadEnd(deadEnd, live, cursor);
+  while (fanning >= 0) {
+    // Emite todos os triângulos ainda vivos à volta do vértice do leque
+    candidates.clear();
+    for (size_t a = offsets[fanning]; a < offsets[fanning + 1]; ++a) {
+      uint32_t tri = adjacency[a];
+      if (emitted[tri]) {
+        continue;
+      }
+      for (int k = 0; k < 3; ++k) {
+        uint32_t vertex = indices[tri * 3 + k];
+        result.push_back(vertex);
+        deadEnd.push_back(vertex);
+        candidates.push_back(vertex);
+        --live[vertex];
+        if (time - cacheTime[vertex] > kCacheSize) {
+          cacheTime[vertex] = time++;
+        }
+      }
+      emitted[tri] = 1;
+    }
+
+    // Escolhe o candidato que continua na cache depois do seu leque
+    int64_t best = -1;
+    int64_t bestPriority = -1;
+    for (uint32_t vertex : candidates) {
+      if (live[vertex] == 0) {
+        continue;
+      }
+      int64_t priority = 0;
+      if (time - cacheTime[vertex] + 2 * live[vertex] <= kCacheSize) {
+        priority = time - cacheTime[vertex];
+      }
+      if (priority > bestPriority) {
+        bestPriority = priority;
+        best = vertex;
+      }
+    }
+    if (best < 0) {
+      best = SkipDeadEnd(deadEnd, live, cursor);
+      hardBoundaries.push_back(result.size() / 3);
+    }
+    fanning = best;
+  }
+  return result;
+}
+
+// Divide os clusters duros em clusters menores onde o ACMR local já é
+// quase tão bom como o do cluster inteiro (Sander et al., secção 4)
+std::vector<size_t> SoftBoundaries(const std::vector<uint32_t> &indices,
+                                   size_t vertexCount,
+                                   const std::vector<size_t> &hardBoundaries) {
+  std::vector<size_t> boundaries;
+  FifoCache cache(vertexCount, kCacheSize);
+  size_t start = 0;
+  for (size_t hardEnd : hardBoundaries) {
+    if (hardEnd <= start) {
+      continue;
+    }
+    // ACMR do cluster duro inteiro
+    cache.Reset();
+    size_t clusterMisses = 0;
+    for (size_t t = start; t < hardEnd; ++t) {
+      clusterMisses += cache.Triangle(&indices[t * 3]);
+    }
+    float threshold = kOverdrawThreshold * static_cast<float>(clusterMisses) /
+                      static_cast<float>(hardEnd - start);
+
+    // Corta assim que o troço atual atinge esse ACMR
+    cache.Reset();
+    size_t softStart = start;
+    size_t misses = 0;
+    boundaries.push_back(start);
+    for (size_t t = start; t < hardEnd; ++t) {
+      misses += cache.Triangle(&indices[t * 3]);
+      size_t count = t + 1 - softStart;
+      if (t + 1 < hardEnd &&
+          static_cast<float>(misses) <= threshold * static_cast<float>(count)) {
+        boundaries.push_back(t + 1);
+        softStart = t + 1;
+        misses = 0;
+        cache.Reset();
+      }
+    }
+    start = hardEnd;
+  }
+  return boundaries;
+}
+
+// Ordena os clusters de fora para dentro para reduzir overdraw
+// (pontuação = posição do cluster ao longo da sua normal média)
+std::vector<uint32_t> SortClusters(const std::vector<uint32_t> &indices,
+                                   const std::vector<Vertex> &vertices,
+                                   const std::vector<size_t> &boundaries) {
+  size_t triangleCount = indices.size() / 3;
+  struct Cluster {
+    size_t begin;
+    size_t end;
+    float score;
+  };
+  std::vector<Cluster> clusters;
+  clusters.reserve(boundaries.size());
+
+  // Centro do mesh (média dos vértices)
+  Vec3 meshCenter;
+  for (const auto &vertex : vertices) {
+    meshCenter = meshCenter + vertex.position;
+  }
+  if (!vertices.empty()) {
+    meshCenter = meshCenter / static_cast<float>(vertices.size());
+  }
+
+  for (size_t c = 0; c < boundaries.size(); ++c) {
+    size_t begin = boundaries[c];
+    size_t end = (c + 1 < boundaries.size()) ? boundaries[c + 1] : triangleCount;
+    // Centroide e normal ponderados pela área dos triângulos
+    Vec3 centroid;
+    Vec3 normal;
+    float area = 0.0f;
+    for (size_t t = begin; t < end; ++t) {
+      const Vec3 &p0 = vertices[indices[t * 3]].position;
+      const Vec3 &p1 = vertices[indices[t * 3 + 1]].position;
+      const Vec3 &p2 = vertices[indices[t * 3 + 2]].position;
+      Vec3 cross = Cross(p1 - p0, p2 - p0);
+      float triArea = Length(cross);
+      centroid = centroid + (p0 + p1 + p2) * (triArea / 3.0f);
+      normal = normal + cross;
+      area += triArea;
+    }
+    if (area > 0.0f) {
+      centroid = centroid / area;
+    }
+    float score = Dot(centroid - meshCenter, Normalize(normal));
+    clusters.push_back({begin, end, score});
+  }
+
+  std::stable_sort(clusters.begin(), clusters.end(),
+                   [](const Cluster &a, const Cluster &b) {
+                     return a.score > b.score;
+                   });
+
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+  for (const auto &cluster : clusters) {
+    result.insert(result.end(), indices.begin() + cluster.begin * 3,
+                  indices.begin() + cluster.end * 3);
+  }
+  return result;
+}
+
+// Renumera os vértices pela ordem do primeiro uso
+void OptimizeVertexFetch(Mesh &mesh) {
+  const uint32_t unused = UINT32_MAX;
+  std::vector<uint32_t> remap(mesh.vertices.size(), unused);
+  std::vector<Vertex> reordered;
+  reordered.reserve(mesh.vertices.size());
+  for (auto &index : mesh.indices) {
+    if (remap[index] == unused) {
+      remap[index] = static_cast<uint32_t>(reordered.size());
+      reordered.push_back(mesh.vertices[index]);
+    }
+    index = remap[index];
+  }
+  mesh.vertices = std::move(reordered);
+}
+}
+
+VertexCacheStats AnalyzeVertexCache(const Mesh &mesh, unsigned cacheSize) {
+  // Conta as falhas de cache pela ordem atual dos triângulos
+  VertexCacheStats stats;
+  stats.triangleCount = mesh.indices.size() / 3;
+  stats.vertexCount = mesh.vertices.size();
+  FifoCache cache(mesh.vertices.size(), cacheSize);
+  for (size_t t = 0; t < stats.triangleCount; ++t) {
+    stats.cacheMisses += cache.Triangle(&mesh.indices[t * 3]);
+  }
+  return stats;
+}
+
+float Acmr(const VertexCacheStats &stats) {
+  return stats.triangleCount
+             ? static_cast<float>(stats.cacheMisses) / stats.triangleCount
+             : 0.0f;
+}
+
+float Atvr(const VertexCacheStats &stats) {
+  return stats.vertexCount
+             ? static_cast<float>(stats.cacheMisses) / stats.vertexCount
+             : 0.0f;
+}
+
+void OptimizeMesh(Mesh &mesh) {
+  if (mesh.indices.size() < 3) {
+    return;
+  }
+  // 1) cache de vértices, 2) overdraw por clusters, 3) localidade de fetch
+  std::vector<size_t> hardBoundaries;
+  std::vector<uint32_t> indices =
+      Tipsify(mesh.indices, mesh.vertices.size(), hardBoundaries);
+  std::vector<size_t> boundaries =
+      SoftBoundaries(indices, mesh.vertices.size(), hardBoundaries);
+  mesh.indices = SortClusters(indices, mesh.vertices, boundaries);
+  OptimizeVertexFetch(mesh);
+}
+
+std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t> &indices,
+                                          size_t vertexCount) {
+  if (indices.size() < 3) {
+    return indices;
+  }
+  std::vector<size_t> hardBoundaries;
+  return Tipsify(indices, vertexCount, hardBoundaries);
+}
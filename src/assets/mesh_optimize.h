@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "assets/model.h"
+
+struct VertexCacheStats {
+  // Triângulos e vértices únicos do mesh
+  size_t triangleCount = 0;
+  size_t vertexCount = 0;
+  // Vértices transformados numa cache FIFO simulada
+  size_t cacheMisses = 0;
+};
+
+// Simula a cache pós-transformação (FIFO) sobre a ordem atual dos índices
+VertexCacheStats AnalyzeVertexCache(const Mesh &mesh, unsigned cacheSize = 16);
+// ACMR: vértices transformados por triângulo (ótimo ~0.5)
+float Acmr(const VertexCacheStats &stats);
+// ATVR: vértices transformados por vértice único (ótimo 1.0)
+float Atvr(const VertexCacheStats &stats);
+
+// Reordena triângulos (cache + overdraw) e vértices (localidade de fetch)
+void OptimizeMesh(Mesh &mesh);
+// Só a ordem dos triângulos para a cache de vértices (ex.: níveis de LOD,
+// que partilham os vértices do nível 0)
+std::vector<uint32_t> OptimizeVertexCache(const std::vector<uint32_t> &indices,
+                                          size_t vertexCount);
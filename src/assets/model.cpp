@@ -1,41 +1,103 @@
 #include "assets/model.h"
 
 #include <algorithm>
+#include <charconv>
 #include <cmath>
 #include <cstddef>
-#include <fstream>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
-#include <sstream>
+#include <iterator>
+#include <map>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "assets/arena.h"
+#include "assets/asset_archive.h"
+#include "assets/mapped_file.h"
+#include "assets/mesh_cache.h"
+#include "assets/mesh_lod.h"
+#include "assets/mesh_optimize.h"
+#include "assets/residency.h"
+#include "assets/texture.h"
+#include "assets/texture_cache.h"
+#include "assets/thread_pool.h"
 #include "gl_utils.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
 namespace {
-// Remove espaços em branco no início e no fim da string
-std::string Trim(const std::string &s) {
-  size_t start = s.find_first_not_of(" \t\r\n");
-  if (start == std::string::npos) {
-    return {};
+// Caracteres tratados como separadores dentro de uma linha
+bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Remove espaços em branco no início e no fim (sem copiar)
+std::string_view Trim(std::string_view s) {
+  while (!s.empty() && IsSpace(s.front())) {
+    s.remove_prefix(1);
+  }
+  while (!s.empty() && IsSpace(s.back())) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+
+// Devolve a próxima linha do buffer e avança o cursor
+std::string_view NextLine(const char *&cur, const char *end) {
+  const char *lineEnd =
+      static_cast<const char *>(std::memchr(cur, '\n', end - cur));
+  if (!lineEnd) {
+    lineEnd = end;
+  }
+  std::string_view line(cur, static_cast<size_t>(lineEnd - cur));
+  cur = (lineEnd < end) ? lineEnd + 1 : end;
+  return line;
+}
+
+// Extrai o próximo token separado por espaço e consome-o da linha
+std::string_view NextToken(std::string_view &line) {
+  size_t start = 0;
+  while (start < line.size() && IsSpace(line[start])) {
+    ++start;
+  }
+  size_t stop = start;
+  while (stop < line.size() && !IsSpace(line[stop])) {
+    ++stop;
+  }
+  std::string_view token = line.substr(start, stop - start);
+  line.remove_prefix(stop);
+  return token;
+}
+
+// Converte token para float sem alocar (aceita '+' inicial como o stof)
+bool ParseFloat(std::string_view token, float &out) {
+  if (!token.empty() && token.front() == '+') {
+    token.remove_prefix(1);
+  }
+  const char *last = token.data() + token.size();
+  auto result = std::from_chars(token.data(), last, out);
+  return result.ec == std::errc();
+}
+
+// Converte token para inteiro sem alocar
+bool ParseInt(std::string_view token, int &out) {
+  if (!token.empty() && token.front() == '+') {
+    token.remove_prefix(1);
   }
-  size_t end = s.find_last_not_of(" \t\r\n");
-  return s.substr(start, end - start + 1);
+  const char *last = token.data() + token.size();
+  auto result = std::from_chars(token.data(), last, out);
+  return result.ec == std::errc();
 }
 
-// Divide uma linha em partes separadas por espaço
-std::vector<std::string> SplitWhitespace(const std::string &s) {
-  std::istringstream iss(s);
-  std::vector<std::string> parts;
-  std::string part;
-  while (iss >> part) {
-    parts.push_back(part);
+// Lê os próximos N floats da linha; falha se faltar algum
+template <size_t N> bool ParseFloats(std::string_view &line, float (&out)[N]) {
+  for (size_t i = 0; i < N; ++i) {
+    if (!ParseFloat(NextToken(line), out[i])) {
+      return false;
+    }
   }
-  return parts;
+  return true;
 }
 
 // Converte índice OBJ (1-based ou negativo) para 0-based
@@ -54,43 +116,40 @@ struct ObjIndex {
 };
 
 // Lê um token de face no formato v/vt/vn
-ObjIndex ParseFaceToken(const std::string &token) {
-  //estrutura para guardar os indices de cada vertice
-  ObjIndex out;
-  //procura as barras que separam os indices
+bool ParseFaceToken(std::string_view token, ObjIndex &out) {
+  out = ObjIndex{};
+  // procura as barras que separam os indices
   size_t first = token.find('/');
   // se nao houver barras, so tem o indice de posicao
-  if (first == std::string::npos) {
-    out.v = std::stoi(token);
-    return out;
+  if (first == std::string_view::npos) {
+    return ParseInt(token, out.v);
   }
 
   // extrai os indices de posicao, texcoord e normal
   size_t second = token.find('/', first + 1);
-  std::string vStr = token.substr(0, first);
-  std::string vtStr;
-  std::string vnStr;
+  std::string_view vStr = token.substr(0, first);
+  std::string_view vtStr;
+  std::string_view vnStr;
 
   // se nao houver segunda barra, so tem posicao e texcoord
-  if (second == std::string::npos) {
+  if (second == std::string_view::npos) {
     vtStr = token.substr(first + 1);
   } else { // tem posicao, texcoord e normal
     vtStr = token.substr(first + 1, second - first - 1);
     vnStr = token.substr(second + 1);
   }
 
-  // converte strings do obj para inteiros
-  if (!vStr.empty()) {
-    out.v = std::stoi(vStr);
+  // converte os campos presentes (campos vazios ficam a 0)
+  if (!ParseInt(vStr, out.v)) {
+    return false;
   }
-  if (!vtStr.empty()) {
-    out.vt = std::stoi(vtStr);
+  if (!vtStr.empty() && !ParseInt(vtStr, out.vt)) {
+    return false;
   }
-  if (!vnStr.empty()) {
-    out.vn = std::stoi(vnStr);
+  if (!vnStr.empty() && !ParseInt(vnStr, out.vn)) {
+    return false;
   }
-
-  return out;
+  return true;
 }
 
 // extrai o diretorio de um caminho de ficheiro
@@ -101,215 +160,924 @@ std::string Dirname(const std::string &path) {
   }
   return path.substr(0, pos + 1);
 }
+}
 
 // Carrega materiais do ficheiro MTL
 bool LoadMtl(const std::string &path, std::unordered_map<std::string, Material> &materials) {
-  // Abre o ficheiro MTL
-  std::ifstream file(path);
-  if (!file) {
+  // Mapeia o ficheiro MTL em memória (ou usa a vista do arquivo)
+  MappedFile file;
+  if (!OpenAsset(path, file)) {
     std::cerr << "Nao foi possivel abrir MTL: " << path << "\n";
     return false;
   }
 
-  // Lê o ficheiro linha a linha
   std::string baseDir = Dirname(path);
   Material *current = nullptr;
-  std::string line;
+  const char *cur = file.data;
+  const char *end = file.data + file.size;
   // Percorre cada linha do ficheiro
-  while (std::getline(file, line)) {
-    line = Trim(line);
+  while (cur < end) {
+    std::string_view line = Trim(NextLine(cur, end));
     if (line.empty() || line[0] == '#') {
       continue;
     }
 
     // Processa comandos do MTL
-    if (line.rfind("newmtl ", 0) == 0) {
-      Material mat;
-      mat.name = Trim(line.substr(7));
-      materials[mat.name] = mat;
-      current = &materials[mat.name];
-    } else if (line.rfind("Kd ", 0) == 0 && current) { // Cor difusa - cor quando a luz incide
-      auto parts = SplitWhitespace(line);
-      if (parts.size() >= 4) {
-        current->kd = {std::stof(parts[1]), std::stof(parts[2]), std::stof(parts[3])};
+    std::string_view rest = line;
+    std::string_view keyword = NextToken(rest);
+    rest = Trim(rest);
+    if (keyword == "newmtl" && !rest.empty()) {
+      std::string name(rest);
+      Material &mat = materials[name];
+      mat = Material{};
+      mat.name = std::move(name);
+      current = &mat;
+    } else if (keyword == "Kd" && current) { // Cor difusa - cor quando a luz incide
+      float kd[3];
+      if (ParseFloats(rest, kd)) {
+        current->kd = {kd[0], kd[1], kd[2]};
       }
-    } else if (line.rfind("map_Kd ", 0) == 0 && current) { // Textura difusa
-      std::string mapName = Trim(line.substr(7));
-      if (!mapName.empty()) {
-        current->mapKd = baseDir + mapName;
+    } else if (keyword == "map_Kd" && current) { // Textura difusa
+      if (!rest.empty()) {
+        current->mapKd = baseDir;
+        current->mapKd.append(rest);
       }
     }
   }
 
+  UnmapFile(file);
   return true;
 }
-}
 
-// Carrega modelo OBJ
-bool LoadObj(const std::string &path, Model &model) {
-  // Abre o ficheiro OBJ
-  std::ifstream file(path);
-  if (!file) {
-    std::cerr << "Nao foi possivel abrir OBJ: " << path << "\n";
-    return false;
-  }
+namespace {
+// Face lida de um chunk; guarda o tamanho dos arrays no momento da leitura
+// para que os índices negativos (relativos) resolvam como no parser serial
+struct ObjFace {
+  uint32_t firstIndex = 0;
+  uint32_t indexCount = 0;
+  int positionCount = 0;
+  int texcoordCount = 0;
+  int normalCount = 0;
+};
 
-  // Buffers temporários para os dados do OBJ- guarda posicoes, normais, texcoords, materiais e meshes na CPU
-  std::vector<Vec3> positions;
-  std::vector<Vec3> normals;
-  std::vector<Vec2> texcoords;
-  std::unordered_map<std::string, Material> materials;
-  std::unordered_map<std::string, Mesh> meshBuilders;
+struct ObjEvent {
+  // Comandos que mudam o estado do parser entre faces
+  enum class Type { UseMtl, Object, MtlLib };
+  Type type = Type::UseMtl;
+  // Nome (aponta para o ficheiro mapeado)
+  std::string_view name;
+  // Número de faces do chunk lidas antes deste comando
+  size_t faceCount = 0;
+  // Id do material (UseMtl), atribuído depois do parse
+  int materialId = 0;
+};
 
-  //se o obj nao especificar material, usa o default
-  std::string currentMaterial = "default";
-  meshBuilders[currentMaterial] = Mesh{};
-  meshBuilders[currentMaterial].materialName = currentMaterial;
-  std::string currentObject;
-  bool skipCurrentObject = false;
+struct ObjChunk {
+  // Intervalo do ficheiro, sempre em fronteiras de linha
+  const char *begin = nullptr;
+  const char *end = nullptr;
+  // Linhas de cada tipo (pré-passagem): capacidade exata dos arrays
+  size_t positionLines = 0;
+  size_t texcoordLines = 0;
+  size_t normalLines = 0;
+  size_t faceLines = 0;
+  size_t faceTokens = 0;
+  // Dados do chunk na arena; os atributos são fatias dos arrays globais
+  FixedArray<Vec3> positions;
+  FixedArray<Vec3> normals;
+  FixedArray<Vec2> texcoords;
+  FixedArray<ObjIndex> faceIndices;
+  FixedArray<ObjFace> faces;
+  std::vector<ObjEvent> events;
+  // Offsets globais dos arrays deste chunk
+  int positionBase = 0;
+  int texcoordBase = 0;
+  int normalBase = 0;
+  // Estado herdado do chunk anterior
+  int startMaterialId = 0;
+  bool startSkip = false;
+  // Posição de escrita por material no array final de vértices
+  std::vector<size_t> writeOffsets;
+};
 
-  std::string baseDir = Dirname(path);
+// Divide o ficheiro em chunks que começam sempre no início de uma linha
+std::vector<ObjChunk> SplitChunks(const char *data, size_t size,
+                                  unsigned count) {
+  std::vector<ObjChunk> chunks;
+  const char *end = data + size;
+  const char *begin = data;
+  for (unsigned i = 1; i <= count && begin < end; ++i) {
+    const char *split = (i == count) ? end : data + size / count * i;
+    if (split < begin) {
+      continue;
+    }
+    if (split < end) {
+      const char *newline =
+          static_cast<const char *>(std::memchr(split, '\n', end - split));
+      split = newline ? newline + 1 : end;
+    }
+    ObjChunk chunk;
+    chunk.begin = begin;
+    chunk.end = split;
+    chunks.push_back(std::move(chunk));
+    begin = split;
+  }
+  return chunks;
+}
 
-  std::string line;
+// Pré-passagem: conta as linhas de cada tipo para reservar tudo de uma vez
+void CountChunk(ObjChunk &chunk) {
+  const char *cur = chunk.begin;
+  while (cur < chunk.end) {
+    std::string_view rest = Trim(NextLine(cur, chunk.end));
+    std::string_view keyword = NextToken(rest);
+    if (keyword == "v") {
+      ++chunk.positionLines;
+    } else if (keyword == "vt") {
+      ++chunk.texcoordLines;
+    } else if (keyword == "vn") {
+      ++chunk.normalLines;
+    } else if (keyword == "f") {
+      ++chunk.faceLines;
+      for (std::string_view token = NextToken(rest); !token.empty();
+           token = NextToken(rest)) {
+        ++chunk.faceTokens;
+      }
+    }
+  }
+}
 
-  // Percorre cada linha do ficheiro
-  while (std::getline(file, line)) {
-    line = Trim(line);
+// Fatia de capacity elementos de um array global, a partir de offset
+template <typename T>
+FixedArray<T> Slice(FixedArray<T> &array, size_t offset, size_t capacity) {
+  FixedArray<T> slice;
+  slice.items = array.items + offset;
+  slice.capacity = capacity;
+  return slice;
+}
+
+// Junta a fatia ao fim do array global (só move se houve linhas inválidas
+// em chunks anteriores)
+template <typename T>
+void AppendSlice(FixedArray<T> &array, FixedArray<T> &slice) {
+  if (slice.items != array.end() && slice.count > 0) {
+    std::memmove(array.end(), slice.items, slice.count * sizeof(T));
+  }
+  slice.items = array.end();
+  array.count += slice.count;
+}
+
+// Lê as linhas de um chunk sem resolver índices nem materiais
+void ParseChunk(ObjChunk &chunk) {
+  const char *cur = chunk.begin;
+  while (cur < chunk.end) {
+    std::string_view line = Trim(NextLine(cur, chunk.end));
     // Ignora linhas vazias ou comentários
     if (line.empty() || line[0] == '#') {
       continue;
     }
 
-    auto parts = SplitWhitespace(line);
-    if (parts.empty()) {
-      continue;
-    }
+    std::string_view rest = line;
+    std::string_view keyword = NextToken(rest);
 
-    // Processa comandos do OBJ
-    if (parts[0] == "o" && parts.size() >= 2) {
-      // Guarda o nome do objeto atual (ignora Cube)
-      currentObject = parts[1];
-      skipCurrentObject = (currentObject == "Cube");
-    } else if (parts[0] == "mtllib") { // carrega materiais do ficheiro MTL
-      // Lê o ficheiro de materiais
-      size_t mtllibPos = line.find("mtllib");
-      std::string mtlName = Trim(line.substr(mtllibPos + 6));
-      std::string mtlPath = baseDir + mtlName;
-      if (!LoadMtl(mtlPath, materials)) {
-        std::string fallback = baseDir + "pista.mtl";
-        LoadMtl(fallback, materials);
-      }
-    } else if (parts[0] == "v" && parts.size() >= 4) {
+    // Processa comandos do OBJ (os mais frequentes primeiro)
+    if (keyword == "v") {
       // Lê posições dos vértices
-      positions.push_back(
-          {std::stof(parts[1]), std::stof(parts[2]), std::stof(parts[3])});
-    } else if (parts[0] == "vt" && parts.size() >= 3) {
+      float p[3];
+      if (ParseFloats(rest, p)) {
+        chunk.positions.push_back({p[0], p[1], p[2]});
+      }
+    } else if (keyword == "vt") {
       // Lê coordenadas de textura
-      texcoords.push_back({std::stof(parts[1]), std::stof(parts[2])});
-    } else if (parts[0] == "vn" && parts.size() >= 4) {
+      float t[2];
+      if (ParseFloats(rest, t)) {
+        chunk.texcoords.push_back({t[0], t[1]});
+      }
+    } else if (keyword == "vn") {
       // Lê normais
-      normals.push_back(
-          {std::stof(parts[1]), std::stof(parts[2]), std::stof(parts[3])});
-    } else if (parts[0] == "usemtl" && parts.size() >= 2) {
-      // Troca de material
-      currentMaterial = parts[1];
-      if (meshBuilders.find(currentMaterial) == meshBuilders.end()) {
-        Mesh mesh;
-        mesh.materialName = currentMaterial;
-        meshBuilders[currentMaterial] = mesh;
+      float n[3];
+      if (ParseFloats(rest, n)) {
+        chunk.normals.push_back({n[0], n[1], n[2]});
       }
-    } else if (parts[0] == "f" && parts.size() >= 4) {
-      // Lê faces e transforma em triângulos
-      if (skipCurrentObject) {
+    } else if (keyword == "f") {
+      // Guarda os índices da face; a triangulação é feita depois
+      ObjFace face;
+      face.firstIndex = static_cast<uint32_t>(chunk.faceIndices.size());
+      bool valid = true;
+      for (std::string_view token = NextToken(rest); !token.empty();
+           token = NextToken(rest)) {
+        ObjIndex idx;
+        if (!ParseFaceToken(token, idx)) {
+          valid = false;
+          break;
+        }
+        chunk.faceIndices.push_back(idx);
+      }
+      face.indexCount =
+          static_cast<uint32_t>(chunk.faceIndices.size()) - face.firstIndex;
+      if (!valid || face.indexCount < 3) {
+        chunk.faceIndices.resize(face.firstIndex);
         continue;
       }
-      std::vector<ObjIndex> indices;
-      indices.reserve(parts.size() - 1)
-      for (size_t i = 1; i < parts.size(); ++i) {
-        indices.push_back(ParseFaceToken(parts[i]));
+      face.positionCount = static_cast<int>(chunk.positions.size());
+      face.texcoordCount = static_cast<int>(chunk.texcoords.size());
+      face.normalCount = static_cast<int>(chunk.normals.size());
+      chunk.faces.push_back(face);
+    } else if (keyword == "usemtl") {
+      // Troca de material
+      std::string_view name = NextToken(rest);
+      if (!name.empty()) {
+        chunk.events.push_back(
+            {ObjEvent::Type::UseMtl, name, chunk.faces.size(), 0});
+      }
+    } else if (keyword == "o") {
+      // Nome do objeto atual (Cube é ignorado)
+      std::string_view name = NextToken(rest);
+      if (!name.empty()) {
+        chunk.events.push_back(
+            {ObjEvent::Type::Object, name, chunk.faces.size(), 0});
+      }
+    } else if (keyword == "mtllib") {
+      // Ficheiro de materiais (o nome pode ter espaços)
+      chunk.events.push_back(
+          {ObjEvent::Type::MtlLib, Trim(rest), chunk.faces.size(), 0});
+    }
+  }
+}
+
+// Mesh de um material enquanto é construído (tudo na arena)
+struct MeshBuilder {
+  std::string materialName;
+  // Sopa de triângulos (3 vértices por triângulo); depois da soldadura os
+  // vértices únicos ficam no início do mesmo array
+  FixedArray<Vertex> vertices;
+  // Índices para os vértices únicos (um por vértice da sopa)
+  FixedArray<uint32_t> indices;
+};
+
+// Percorre as faces de um chunk aplicando os eventos pela ordem do ficheiro
+template <typename Fn> void ForEachFace(const ObjChunk &chunk, const Fn &fn) {
+  int materialId = chunk.startMaterialId;
+  bool skip = chunk.startSkip;
+  size_t nextEvent = 0;
+  for (size_t f = 0; f <= chunk.faces.size(); ++f) {
+    while (nextEvent < chunk.events.size() &&
+           chunk.events[nextEvent].faceCount == f) {
+      const ObjEvent &event = chunk.events[nextEvent++];
+      if (event.type == ObjEvent::Type::UseMtl) {
+        materialId = event.materialId;
+      } else if (event.type == ObjEvent::Type::Object) {
+        skip = (event.name == "Cube");
       }
+    }
+    if (f < chunk.faces.size() && !skip) {
+      fn(chunk.faces[f], materialId);
+    }
+  }
+}
 
-      // Transforma face em triângulos (fan triangulation)
-      for (size_t i = 1; i + 1 < indices.size(); ++i) {
-        ObjIndex i0 = indices[0];
-        ObjIndex i1 = indices[i];
-        ObjIndex i2 = indices[i + 1];
-
-        // Posições dos vértices
-        Vec3 p0 = positions[ResolveIndex(i0.v, static_cast<int>(positions.size()))];
-        Vec3 p1 = positions[ResolveIndex(i1.v, static_cast<int>(positions.size()))];
-        Vec3 p2 = positions[ResolveIndex(i2.v, static_cast<int>(positions.size()))];
-
-        // Calcula normal de fallback quando não há normais
-        bool hasNormals =
-            (i0.vn != 0 && i1.vn != 0 && i2.vn != 0 && !normals.empty());
-        Vec3 faceNormal = Normalize(Cross(p1 - p0, p2 - p0));
-
-        auto addVertex = [&](const ObjIndex &idx, const Vec3 &fallbackNormal,
-                             const Vec3 &pos) {
-          Vec3 normal = fallbackNormal;
-          if (hasNormals) {
-            int normalIndex =
-                ResolveIndex(idx.vn, static_cast<int>(normals.size()));
-            if (normalIndex >= 0 &&
-                normalIndex < static_cast<int>(normals.size())) {
-              normal = normals[normalIndex];
-            }
+// Triangula as faces de um chunk diretamente nos arrays finais de vértices
+void TriangulateChunk(ObjChunk &chunk, const FixedArray<Vec3> &positions,
+                      const FixedArray<Vec3> &normals,
+                      const FixedArray<Vec2> &texcoords,
+                      std::vector<MeshBuilder> &builders) {
+  ForEachFace(chunk, [&](const ObjFace &face, int materialId) {
+    // Tamanho dos arrays globais no momento em que a face foi lida
+    int positionCount = chunk.positionBase + face.positionCount;
+    int texcoordCount = chunk.texcoordBase + face.texcoordCount;
+    int normalCount = chunk.normalBase + face.normalCount;
+    Vertex *out = builders[materialId].vertices.data() +
+                  chunk.writeOffsets[materialId];
+    const ObjIndex *indices = chunk.faceIndices.data() + face.firstIndex;
+
+    // Transforma face em triângulos (fan triangulation)
+    for (uint32_t i = 1; i + 1 < face.indexCount; ++i) {
+      ObjIndex i0 = indices[0];
+      ObjIndex i1 = indices[i];
+      ObjIndex i2 = indices[i + 1];
+
+      // Posições dos vértices
+      Vec3 p0 = positions[ResolveIndex(i0.v, positionCount)];
+      Vec3 p1 = positions[ResolveIndex(i1.v, positionCount)];
+      Vec3 p2 = positions[ResolveIndex(i2.v, positionCount)];
+
+      // Calcula normal de fallback quando não há normais
+      bool hasNormals =
+          (i0.vn != 0 && i1.vn != 0 && i2.vn != 0 && normalCount > 0);
+      Vec3 faceNormal = Normalize(Cross(p1 - p0, p2 - p0));
+
+      auto addVertex = [&](const ObjIndex &idx, const Vec3 &fallbackNormal,
+                           const Vec3 &pos) {
+        Vec3 normal = fallbackNormal;
+        if (hasNormals) {
+          int normalIndex = ResolveIndex(idx.vn, normalCount);
+          if (normalIndex >= 0 && normalIndex < normalCount) {
+            normal = normals[normalIndex];
           }
+        }
 
-          // Coordenada de textura, se existir
-          Vec2 texCoord = {0.0f, 0.0f};
-          if (idx.vt != 0 && !texcoords.empty()) {
-            int texIndex =
-                ResolveIndex(idx.vt, static_cast<int>(texcoords.size()));
-            if (texIndex >= 0 &&
-                texIndex < static_cast<int>(texcoords.size())) {
-              texCoord = texcoords[texIndex];
-            }
+        // Coordenada de textura, se existir
+        Vec2 texCoord = {0.0f, 0.0f};
+        if (idx.vt != 0 && texcoordCount > 0) {
+          int texIndex = ResolveIndex(idx.vt, texcoordCount);
+          if (texIndex >= 0 && texIndex < texcoordCount) {
+            texCoord = texcoords[texIndex];
           }
+        }
+
+        *out++ = {pos, normal, texCoord};
+      };
+
+      addVertex(i0, faceNormal, p0);
+      addVertex(i1, faceNormal, p1);
+      addVertex(i2, faceNormal, p2);
+    }
+    chunk.writeOffsets[materialId] += (face.indexCount - 2) * 3;
+  });
+}
 
-          meshBuilders[currentMaterial].vertices.push_back(
-              {pos, normal, texCoord});
-        };
+// Hash dos bits de um vértice (posição, normal e texcoord)
+uint64_t HashVertex(const Vertex &vertex) {
+  uint32_t words[sizeof(Vertex) / sizeof(uint32_t)];
+  std::memcpy(words, &vertex, sizeof(Vertex));
+  uint64_t hash = 1469598103934665603ull;
+  for (uint32_t word : words) {
+    hash = (hash ^ word) * 1099511628211ull;
+  }
+  return hash ^ (hash >> 29);
+}
+
+// Junta vértices repetidos (bit a bit) e gera a lista de índices. Os
+// vértices únicos são compactados no próprio array (o k-ésimo único nunca
+// vem depois da sua primeira ocorrência); table tem tableSize entradas
+void WeldVertices(MeshBuilder &builder, uint32_t *table, size_t tableSize) {
+  FixedArray<Vertex> &vertices = builder.vertices;
+  FixedArray<uint32_t> &indices = builder.indices;
+
+  // Endereçamento aberto com o índice único + 1 (0 = livre)
+  std::memset(table, 0, tableSize * sizeof(uint32_t));
+  const size_t mask = tableSize - 1;
+  size_t uniqueCount = 0;
 
-        addVertex(i0, faceNormal, p0);
-        addVertex(i1, faceNormal, p1);
-        addVertex(i2, faceNormal, p2);
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    const Vertex vertex = vertices[i];
+    size_t slot = static_cast<size_t>(HashVertex(vertex)) & mask;
+    while (true) {
+      uint32_t entry = table[slot];
+      if (entry == 0) {
+        // Vértice novo: a ordem de primeira ocorrência é mantida
+        vertices[uniqueCount++] = vertex;
+        table[slot] = static_cast<uint32_t>(uniqueCount);
+        indices.push_back(static_cast<uint32_t>(uniqueCount - 1));
+        break;
       }
+      if (std::memcmp(&vertices[entry - 1], &vertex, sizeof(Vertex)) == 0) {
+        indices.push_back(entry - 1);
+        break;
+      }
+      slot = (slot + 1) & mask;
     }
   }
+  vertices.resize(uniqueCount);
+}
+
+// Tamanho da tabela de soldadura (potência de 2, pelo menos 2x os vértices)
+size_t WeldTableSize(size_t vertexCount) {
+  size_t tableSize = 16;
+  while (tableSize < vertexCount * 2) {
+    tableSize <<= 1;
+  }
+  return tableSize;
+}
 
-  bool hasBounds = false;
-  Vec3 minPos;
-  Vec3 maxPos;
+// Converte float para half-float (IEEE 754, arredondamento ao mais próximo)
+uint16_t FloatToHalf(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  uint32_t sign = (bits >> 16) & 0x8000u;
+  uint32_t absBits = bits & 0x7fffffffu;
+  if (absBits >= 0x7f800000u) { // inf ou NaN
+    return static_cast<uint16_t>(sign | 0x7c00u |
+                                 (absBits > 0x7f800000u ? 0x200u : 0u));
+  }
+  if (absBits >= 0x477ff000u) { // fora do alcance: satura para infinito
+    return static_cast<uint16_t>(sign | 0x7c00u);
+  }
+  if (absBits < 0x38800000u) { // subnormal (ou zero) em half
+    float magnitude;
+    std::memcpy(&magnitude, &absBits, sizeof(magnitude));
+    return static_cast<uint16_t>(
+        sign | static_cast<uint32_t>(std::nearbyint(magnitude * 16777216.0f)));
+  }
+  // Normal: reajusta o expoente e arredonda a mantissa (ties-to-even)
+  uint32_t half = absBits - 0x38000000u;
+  half += 0xfffu + ((half >> 13) & 1u);
+  return static_cast<uint16_t>(sign | (half >> 13));
+}
 
-  // Calcula bounding box a partir dos meshes
-  for (auto &entry : meshBuilders) {
-    Mesh &mesh = entry.second;
-    if (mesh.vertices.empty()) {
-      continue;
+// Codifica uma normal em octaedro (2 componentes snorm16)
+void EncodeOctahedral(const Vec3 &normal, int16_t out[2]) {
+  float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+  float x = (sum > 0.0f) ? normal.x / sum : 0.0f;
+  float y = (sum > 0.0f) ? normal.y / sum : 0.0f;
+  if (normal.z < 0.0f) {
+    // Hemisfério de baixo é dobrado sobre os cantos do quadrado
+    float foldX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+    float foldY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+    x = foldX;
+    y = foldY;
+  }
+  out[0] = static_cast<int16_t>(std::lround(std::clamp(x, -1.0f, 1.0f) * 32767.0f));
+  out[1] = static_cast<int16_t>(std::lround(std::clamp(y, -1.0f, 1.0f) * 32767.0f));
+}
+
+// Reserva espaço partilhado para o mesh e copia os vértices já no formato
+// final e todos os níveis de índices (16 bits quando possível: os índices
+// são relativos ao primeiro vértice do mesh)
+void UploadMeshGeometry(Mesh &mesh, bool compact, const void *vertices) {
+  std::vector<uint32_t> allIndices = mesh.indices;
+  allIndices.insert(allIndices.end(), mesh.lodIndices.begin(),
+                    mesh.lodIndices.end());
+  GLenum indexType =
+      mesh.vertices.size() <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+  mesh.geometry = AllocateGeometry(compact, indexType, mesh.vertices.size(),
+                                   allIndices.size());
+  if (indexType == GL_UNSIGNED_SHORT) {
+    std::vector<uint16_t> shortIndices(allIndices.begin(), allIndices.end());
+    UploadGeometry(mesh.geometry, vertices, shortIndices.data());
+  } else {
+    UploadGeometry(mesh.geometry, vertices, allIndices.data());
+  }
+}
+
+// Entrada do bloco Materials em std140: cor difusa e (grupo, camada,
+// tem textura, padding)
+struct GpuMaterial {
+  float kd[4];
+  int32_t params[4];
+};
+
+// Nomes dos materiais usados por algum mesh, por ordem alfabética (camadas
+// e índices estáveis); os outros do MTL não ocupam camadas nem VRAM
+std::vector<std::string> UsedMaterialNames(const Model &model) {
+  std::unordered_set<std::string> used;
+  for (const auto &mesh : model.meshes) {
+    used.insert(mesh.materialName);
+  }
+  std::vector<std::string> names;
+  for (const auto &entry : model.materials) {
+    if (used.count(entry.first)) {
+      names.push_back(entry.first);
     }
+  }
+  std::sort(names.begin(), names.end());
+  return names;
+}
 
-    for (const auto &vertex : mesh.vertices) {
-      if (!hasBounds) {
-        minPos = vertex.position;
-        maxPos = vertex.position;
-        hasBounds = true;
+// Memória de trabalho partilhada por todos os clusters de um mesh
+struct ClusterScratch {
+  // Índice local de cada vértice do mesh (UINT32_MAX = não usado)
+  FixedArray<uint32_t> remap;
+  // Vértices do mesh usados pelo cluster atual, pela ordem local
+  FixedArray<uint32_t> order;
+};
+
+// Copia os triângulos indicados para um mesh novo com vértices locais
+// (arrays já com o tamanho final)
+Mesh ExtractTriangles(const MeshBuilder &mesh, const uint32_t *triangles,
+                      size_t count, ClusterScratch &scratch) {
+  const uint32_t unused = UINT32_MAX;
+  Mesh cluster;
+  cluster.materialName = mesh.materialName;
+  cluster.indices.resize(count * 3);
+  scratch.order.resize(0);
+  for (size_t t = 0; t < count; ++t) {
+    for (int c = 0; c < 3; ++c) {
+      uint32_t index = mesh.indices[triangles[t] * 3 + c];
+      if (scratch.remap[index] == unused) {
+        scratch.remap[index] = static_cast<uint32_t>(scratch.order.size());
+        scratch.order.push_back(index);
+      }
+      cluster.indices[t * 3 + c] = scratch.remap[index];
+    }
+  }
+  // Copia os vértices e deixa o remap limpo para o próximo cluster
+  cluster.vertices.reserve(scratch.order.size());
+  for (uint32_t index : scratch.order) {
+    cluster.vertices.push_back(mesh.vertices[index]);
+    scratch.remap[index] = unused;
+  }
+  return cluster;
+}
+
+// Divide recursivamente pela mediana dos centróides no eixo mais longo
+// até cada parte ter no máximo maxTriangles
+void SplitTriangles(const MeshBuilder &mesh, const Vec3 *centroids,
+                    uint32_t *triangles, size_t count, size_t maxTriangles,
+                    ClusterScratch &scratch, std::vector<Mesh> &out) {
+  if (count <= maxTriangles) {
+    out.push_back(ExtractTriangles(mesh, triangles, count, scratch));
+    return;
+  }
+  Vec3 minC = centroids[triangles[0]];
+  Vec3 maxC = minC;
+  for (size_t t = 1; t < count; ++t) {
+    const Vec3 &c = centroids[triangles[t]];
+    minC = {std::min(minC.x, c.x), std::min(minC.y, c.y),
+            std::min(minC.z, c.z)};
+    maxC = {std::max(maxC.x, c.x), std::max(maxC.y, c.y),
+            std::max(maxC.z, c.z)};
+  }
+  Vec3 extent = maxC - minC;
+  float Vec3::*axis = &Vec3::x;
+  if (extent.y > extent.x && extent.y >= extent.z) {
+    axis = &Vec3::y;
+  } else if (extent.z > extent.x && extent.z > extent.y) {
+    axis = &Vec3::z;
+  }
+  size_t half = count / 2;
+  std::nth_element(triangles, triangles + half, triangles + count,
+                   [&](uint32_t a, uint32_t b) {
+                     return centroids[a].*axis < centroids[b].*axis;
+                   });
+  SplitTriangles(mesh, centroids, triangles, half, maxTriangles, scratch, out);
+  SplitTriangles(mesh, centroids, triangles + half, count - half,
+                 maxTriangles, scratch, out);
+}
+
+// Passa o mesh da arena para o modelo, partindo os grandes em clusters
+// espaciais (cada um com o seu AABB e vértices contíguos). Os arrays de
+// trabalho vêm de scratch
+void SplitIntoClusters(const MeshBuilder &mesh, size_t maxTriangles,
+                       Arena &scratch, std::vector<Mesh> &out) {
+  size_t triangleCount = mesh.indices.size() / 3;
+  if (maxTriangles == 0 || triangleCount <= maxTriangles) {
+    Mesh whole;
+    whole.materialName = mesh.materialName;
+    whole.vertices.assign(mesh.vertices.begin(), mesh.vertices.end());
+    whole.indices.assign(mesh.indices.begin(), mesh.indices.end());
+    out.push_back(std::move(whole));
+    return;
+  }
+  FixedArray<Vec3> centroids = ArenaArray<Vec3>(scratch, triangleCount);
+  FixedArray<uint32_t> triangles = ArenaArray<uint32_t>(scratch, triangleCount);
+  for (size_t t = 0; t < triangleCount; ++t) {
+    centroids.push_back((mesh.vertices[mesh.indices[t * 3]].position +
+                         mesh.vertices[mesh.indices[t * 3 + 1]].position +
+                         mesh.vertices[mesh.indices[t * 3 + 2]].position) /
+                        3.0f);
+    triangles.push_back(static_cast<uint32_t>(t));
+  }
+  ClusterScratch clusterScratch;
+  clusterScratch.remap = ArenaArray<uint32_t>(scratch, mesh.vertices.size());
+  clusterScratch.remap.resize(mesh.vertices.size());
+  std::fill(clusterScratch.remap.begin(), clusterScratch.remap.end(),
+            UINT32_MAX);
+  clusterScratch.order = ArenaArray<uint32_t>(scratch, maxTriangles * 3);
+  SplitTriangles(mesh, centroids.data(), triangles.data(), triangleCount,
+                 maxTriangles, clusterScratch, out);
+}
+
+// Escolhe o número de chunks: ficheiros pequenos não compensam threads
+unsigned ChooseChunkCount(size_t fileSize, unsigned requested) {
+  if (requested > 0) {
+    return requested;
+  }
+  const size_t minChunkBytes = 512 * 1024;
+  unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+  size_t bySize = std::max<size_t>(1, fileSize / minChunkBytes);
+  return static_cast<unsigned>(std::min<size_t>(hw, bySize));
+}
+}
+
+// Carrega modelo OBJ
+bool LoadObj(const std::string &path, Model &model,
+             const ObjLoadConfig &config, ObjLoadStats *stats) {
+  ObjLoadStats localStats;
+  ObjLoadStats &memory = stats ? *stats : localStats;
+  memory = ObjLoadStats{};
+
+  // Cache binário válido: evita o parse de texto por completo
+  if (config.useCache && LoadMeshCache(path, config, model)) {
+    memory.fromCache = true;
+    memory.finalBytes = ModelMemoryBytes(model);
+    memory.peakResidentBytes = PeakResidentBytes();
+    return true;
+  }
+
+  // Mapeia o ficheiro OBJ; as linhas são lidas diretamente do mapeamento
+  MappedFile file;
+  if (!OpenAsset(path, file)) {
+    std::cerr << "Nao foi possivel abrir OBJ: " << path << "\n";
+    return false;
+  }
+
+  // Toda a memória temporária vem de duas arenas: a do parse (atributos,
+  // faces, tabelas) é largada entre fases, a dos meshes vive até ao fim
+  Arena parseArena;
+  Arena meshArena;
+  auto notePeak = [&]() {
+    memory.transientPeakBytes =
+        std::max(memory.transientPeakBytes,
+                 parseArena.reservedBytes + meshArena.reservedBytes);
+  };
+
+  // Fases paralelas no pool partilhado (a thread atual também trabalha)
+  ThreadPool &pool = SharedThreadPool();
+
+  // Fase 0: pré-passagem paralela que só conta linhas de cada tipo
+  std::vector<ObjChunk> chunks = SplitChunks(
+      file.data, file.size, ChooseChunkCount(file.size, config.threadCount));
+  ParallelFor(pool, chunks.size(), [&](size_t i) { CountChunk(chunks[i]); });
+
+  // Arrays globais de atributos com o tamanho exato; cada chunk escreve
+  // diretamente na sua fatia (índices OBJ são globais ao ficheiro)
+  size_t positionLines = 0;
+  size_t texcoordLines = 0;
+  size_t normalLines = 0;
+  for (const auto &chunk : chunks) {
+    positionLines += chunk.positionLines;
+    texcoordLines += chunk.texcoordLines;
+    normalLines += chunk.normalLines;
+  }
+  FixedArray<Vec3> positions = ArenaArray<Vec3>(parseArena, positionLines);
+  FixedArray<Vec3> normals = ArenaArray<Vec3>(parseArena, normalLines);
+  FixedArray<Vec2> texcoords = ArenaArray<Vec2>(parseArena, texcoordLines);
+  positionLines = texcoordLines = normalLines = 0;
+  for (auto &chunk : chunks) {
+    chunk.positions = Slice(positions, positionLines, chunk.positionLines);
+    chunk.texcoords = Slice(texcoords, texcoordLines, chunk.texcoordLines);
+    chunk.normals = Slice(normals, normalLines, chunk.normalLines);
+    positionLines += chunk.positionLines;
+    texcoordLines += chunk.texcoordLines;
+    normalLines += chunk.normalLines;
+    chunk.faceIndices = ArenaArray<ObjIndex>(parseArena, chunk.faceTokens);
+    chunk.faces = ArenaArray<ObjFace>(parseArena, chunk.faceLines);
+  }
+  notePeak();
+
+  // Fase 1: cada chunk lê v/vt/vn/f em paralelo para a sua parte
+  ParallelFor(pool, chunks.size(), [&](size_t i) { ParseChunk(chunks[i]); });
+
+  // Fase 2 (serial, barata): materiais, offsets globais e estado entre chunks
+  std::unordered_map<std::string, Material> materials;
+  std::vector<MeshBuilder> builders;
+  std::unordered_map<std::string_view, int> materialIds;
+  std::string baseDir = Dirname(path);
+  // Ficheiros que contribuíram para o modelo (para invalidar o cache)
+  std::vector<std::string> sources = {path};
+
+  auto materialId = [&](std::string_view name) {
+    auto it = materialIds.find(name);
+    if (it != materialIds.end()) {
+      return it->second;
+    }
+    // A ordem de inserção é a mesma do parser serial
+    int id = static_cast<int>(builders.size());
+    builders.emplace_back();
+    builders.back().materialName = std::string(name);
+    materialIds.emplace(name, id);
+    return id;
+  };
+
+  //se o obj nao especificar material, usa o default
+  int currentMaterialId = materialId("default");
+  bool skipCurrentObject = false;
+  for (auto &chunk : chunks) {
+    // Linhas inválidas deixam buracos: junta as fatias (raro, no sítio)
+    AppendSlice(positions, chunk.positions);
+    AppendSlice(texcoords, chunk.texcoords);
+    AppendSlice(normals, chunk.normals);
+    chunk.positionBase =
+        static_cast<int>(positions.size() - chunk.positions.size());
+    chunk.texcoordBase =
+        static_cast<int>(texcoords.size() - chunk.texcoords.size());
+    chunk.normalBase = static_cast<int>(normals.size() - chunk.normals.size());
+    chunk.startMaterialId = currentMaterialId;
+    chunk.startSkip = skipCurrentObject;
+
+    for (auto &event : chunk.events) {
+      if (event.type == ObjEvent::Type::UseMtl) {
+        event.materialId = materialId(event.name);
+        currentMaterialId = event.materialId;
+      } else if (event.type == ObjEvent::Type::Object) {
+        skipCurrentObject = (event.name == "Cube");
       } else {
-        minPos.x = std::min(minPos.x, vertex.position.x);
-        minPos.y = std::min(minPos.y, vertex.position.y);
-        minPos.z = std::min(minPos.z, vertex.position.z);
-        maxPos.x = std::max(maxPos.x, vertex.position.x);
-        maxPos.y = std::max(maxPos.y, vertex.position.y);
-        maxPos.z = std::max(maxPos.z, vertex.position.z);
+        // Lê o ficheiro de materiais
+        std::string mtlPath = baseDir;
+        mtlPath.append(event.name);
+        if (LoadMtl(mtlPath, materials)) {
+          sources.push_back(mtlPath);
+        } else {
+          std::string fallback = baseDir + "pista.mtl";
+          if (LoadMtl(fallback, materials)) {
+            sources.push_back(fallback);
+          }
+        }
+      }
+    }
+  }
+
+  // Conta vértices por material e reserva a posição de escrita de cada chunk
+  std::vector<size_t> vertexTotals(builders.size(), 0);
+  for (auto &chunk : chunks) {
+    chunk.writeOffsets = vertexTotals;
+    ForEachFace(chunk, [&](const ObjFace &face, int id) {
+      vertexTotals[id] += (face.indexCount - 2) * 3;
+    });
+  }
+  for (size_t id = 0; id < builders.size(); ++id) {
+    builders[id].vertices = ArenaArray<Vertex>(meshArena, vertexTotals[id]);
+    builders[id].vertices.resize(vertexTotals[id]);
+  }
+  notePeak();
+
+  // Fase 3: triangulação em paralelo, cada chunk escreve na sua fatia
+  ParallelFor(pool, chunks.size(), [&](size_t i) {
+    TriangulateChunk(chunks[i], positions, normals, texcoords, builders);
+  });
+
+  chunks.clear();
+  UnmapFile(file);
+  ResetArena(parseArena);
+
+  // Geometria indexada: cada mesh fica com vértices únicos + índices
+  std::vector<FixedArray<uint32_t>> weldTables(builders.size());
+  for (size_t id = 0; id < builders.size(); ++id) {
+    MeshBuilder &builder = builders[id];
+    builder.indices = ArenaArray<uint32_t>(meshArena, builder.vertices.size());
+    weldTables[id] = ArenaArray<uint32_t>(
+        parseArena, WeldTableSize(builder.vertices.size()));
+  }
+  notePeak();
+  ParallelFor(pool, builders.size(), [&](size_t id) {
+    WeldVertices(builders[id], weldTables[id].data(),
+                 weldTables[id].capacity);
+  });
+  weldTables.clear();
+  ResetArena(parseArena);
+
+  // Passa para o modelo com o tamanho exato, dividindo os meshes grandes
+  // em clusters espaciais do mesmo material
+  std::vector<Mesh> meshes;
+  for (const MeshBuilder &builder : builders) {
+    if (!builder.vertices.empty()) {
+      SplitIntoClusters(builder, config.clusterTriangles, parseArena, meshes);
+      notePeak();
+      ResetArena(parseArena);
+    }
+  }
+  builders.clear();
+  ResetArena(meshArena);
+
+  // Reordena para a cache de vértices/overdraw; o resultado vai para o cache
+  if (config.optimizeMeshes) {
+    // A análise da cache (antes e depois) só corre para o relatório
+    bool report = config.reportOptimization;
+    std::vector<VertexCacheStats> stats(report ? meshes.size() * 2 : 0);
+    ParallelFor(pool, meshes.size(), [&](size_t id) {
+      if (report) {
+        stats[id * 2] = AnalyzeVertexCache(meshes[id]);
+      }
+      OptimizeMesh(meshes[id]);
+      if (report) {
+        stats[id * 2 + 1] = AnalyzeVertexCache(meshes[id]);
+      }
+    });
+    if (report) {
+      VertexCacheStats before;
+      VertexCacheStats after;
+      for (size_t i = 0; i < stats.size(); ++i) {
+        VertexCacheStats &total = (i % 2 == 0) ? before : after;
+        total.triangleCount += stats[i].triangleCount;
+        total.vertexCount += stats[i].vertexCount;
+        total.cacheMisses += stats[i].cacheMisses;
       }
+      std::cout << "Mesh otimizado " << path << ": ACMR " << Acmr(before)
+                << " -> " << Acmr(after) << ", ATVR " << Atvr(before)
+                << " -> " << Atvr(after) << "\n";
     }
   }
 
-  if (!hasBounds) {
+  if (meshes.empty()) {
     std::cerr << "OBJ sem vertices validos.\n";
     return false;
   }
+  model.meshes = std::move(meshes);
+  NormalizeModel(model);
+
+  // Níveis de LOD (depois da transformação: o erro fica em unidades do
+  // modelo normalizado)
+  if (config.generateLods) {
+    ParallelFor(pool, model.meshes.size(),
+                [&](size_t i) { GenerateMeshLods(model.meshes[i]); });
+  } else {
+    for (auto &mesh : model.meshes) {
+      GenerateMeshLods(mesh, LodConfig{0});
+    }
+  }
+
+  model.materials = std::move(materials);
+
+  // Guarda o resultado para as próximas execuções (o arquivo é só leitura)
+  if (config.useCache && !AssetInArchive(path)) {
+    SaveMeshCache(path, sources, config, model);
+  }
+
+  memory.finalBytes = ModelMemoryBytes(model);
+  memory.peakResidentBytes = PeakResidentBytes();
+  if (config.reportMemory) {
+    const double mb = 1024.0 * 1024.0;
+    std::cout << "Memoria " << path << ": temporaria "
+              << memory.transientPeakBytes / mb << " MB, final "
+              << memory.finalBytes / mb << " MB, pico RSS "
+              << memory.peakResidentBytes / mb << " MB\n";
+  }
+  return true;
+}
+
+size_t ModelMemoryBytes(const Model &model) {
+  size_t bytes = 0;
+  for (const auto &mesh : model.meshes) {
+    bytes += mesh.vertices.capacity() * sizeof(Vertex);
+    bytes += mesh.indices.capacity() * sizeof(uint32_t);
+    bytes += mesh.lodIndices.capacity() * sizeof(uint32_t);
+    bytes += mesh.lods.capacity() * sizeof(MeshLod);
+  }
+  return bytes;
+}
+
+void SetupMesh(Mesh &mesh) {
+  UploadMeshGeometry(mesh, false, mesh.vertices.data());
+}
+
+void SetupMeshCompact(Mesh &mesh, const Vec3 &boundsMin,
+                      const Vec3 &boundsMax) {
+  // Quantiza os vértices para o formato compacto (16 bytes)
+  Vec3 extent = boundsMax - boundsMin;
+  auto quantize = [](float value, float minValue, float range) {
+    if (range <= 0.0f) {
+      return static_cast<uint16_t>(0);
+    }
+    float t = std::clamp((value - minValue) / range, 0.0f, 1.0f);
+    return static_cast<uint16_t>(std::lround(t * 65535.0f));
+  };
+  std::vector<CompactVertex> packed(mesh.vertices.size());
+  for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+    const Vertex &vertex = mesh.vertices[i];
+    CompactVertex &out = packed[i];
+    out.position[0] = quantize(vertex.position.x, boundsMin.x, extent.x);
+    out.position[1] = quantize(vertex.position.y, boundsMin.y, extent.y);
+    out.position[2] = quantize(vertex.position.z, boundsMin.z, extent.z);
+    out.position[3] = 0;
+    EncodeOctahedral(vertex.normal, out.normal);
+    out.texCoord[0] = FloatToHalf(vertex.texCoord.x);
+    out.texCoord[1] = FloatToHalf(vertex.texCoord.y);
+  }
+
+  UploadMeshGeometry(mesh, true, packed.data());
+}
+
+void UploadModel(Model &model, const ModelUploadConfig &config) {
+  for (auto &mesh : model.meshes) {
+    if (config.compactVertices) {
+      SetupMeshCompact(mesh, model.boundsMin, model.boundsMax);
+    } else {
+      SetupMesh(mesh);
+    }
+  }
+}
+
+void ReleaseCpuGeometry(Model &model) {
+  size_t before = ModelMemoryBytes(model);
+  for (auto &mesh : model.meshes) {
+    // swap com vazio: clear não devolve a memória
+    std::vector<Vertex>().swap(mesh.vertices);
+    std::vector<uint32_t>().swap(mesh.indices);
+    std::vector<uint32_t>().swap(mesh.lodIndices);
+  }
+  size_t after = ModelMemoryBytes(model);
+  std::cout << "Geometria so na GPU: " << (before - after) / (1024.0 * 1024.0)
+            << " MB libertados em CPU\n";
+}
+
+void NormalizeModel(Model &model) {
+  if (model.meshes.empty() || model.meshes[0].vertices.empty()) {
+    return;
+  }
+  // Calcula bounding box a partir dos meshes
+  Vec3 minPos = model.meshes[0].vertices[0].position;
+  Vec3 maxPos = minPos;
+  for (const auto &mesh : model.meshes) {
+    for (const auto &vertex : mesh.vertices) {
+      minPos.x = std::min(minPos.x, vertex.position.x);
+      minPos.y = std::min(minPos.y, vertex.position.y);
+      minPos.z = std::min(minPos.z, vertex.position.z);
+      maxPos.x = std::max(maxPos.x, vertex.position.x);
+      maxPos.y = std::max(maxPos.y, vertex.position.y);
+      maxPos.z = std::max(maxPos.z, vertex.position.z);
+    }
+  }
 
   // Centraliza e normaliza o tamanho do modelo
   model.center = (minPos + maxPos) * 0.5f;
@@ -318,108 +1086,227 @@ bool LoadObj(const std::string &path, Model &model) {
   model.scale = (maxDim > 0.0f) ? (1.0f / maxDim) : 1.0f;
   Vec3 scaledMin = (minPos - model.center) * model.scale;
   model.minY = scaledMin.y;
+  model.boundsMin = scaledMin;
+  model.boundsMax = (maxPos - model.center) * model.scale;
 
-  model.meshes.reserve(meshBuilders.size());
-  for (auto &entry : meshBuilders) {
-    Mesh mesh = entry.second;
-    if (mesh.vertices.empty()) {
-      continue;
-    }
-
-    // Aplica a transformação de centro e escala
+  // Aplica a transformação de centro e escala e calcula os volumes de cada
+  // mesh (AABB e esfera, para culling e LOD)
+  for (auto &mesh : model.meshes) {
     for (auto &vertex : mesh.vertices) {
       vertex.position = (vertex.position - model.center) * model.scale;
     }
+    ComputeMeshBounds(mesh);
+  }
+}
 
-    model.meshes.push_back(std::move(mesh));
+void ComputeMeshBounds(Mesh &mesh) {
+  if (mesh.vertices.empty()) {
+    return;
+  }
+  // AABB dos vértices
+  mesh.boundsMin = mesh.vertices[0].position;
+  mesh.boundsMax = mesh.boundsMin;
+  for (const auto &vertex : mesh.vertices) {
+    const Vec3 &p = vertex.position;
+    mesh.boundsMin = {std::min(mesh.boundsMin.x, p.x),
+                      std::min(mesh.boundsMin.y, p.y),
+                      std::min(mesh.boundsMin.z, p.z)};
+    mesh.boundsMax = {std::max(mesh.boundsMax.x, p.x),
+                      std::max(mesh.boundsMax.y, p.y),
+                      std::max(mesh.boundsMax.z, p.z)};
   }
+  // Esfera centrada na AABB
+  mesh.boundsCenter = (mesh.boundsMin + mesh.boundsMax) * 0.5f;
+  mesh.boundsRadius = 0.0f;
+  for (const auto &vertex : mesh.vertices) {
+    mesh.boundsRadius = std::max(mesh.boundsRadius,
+                                 Length(vertex.position - mesh.boundsCenter));
+  }
+}
 
-  model.materials = std::move(materials);
-  return true;
+void DrawMesh(const Mesh &mesh, size_t lodLevel) {
+  // Sem níveis (mesh montado à mão): desenha os índices todos
+  uint32_t offset = 0;
+  uint32_t count = mesh.geometry.indexCount;
+  if (!mesh.lods.empty()) {
+    const MeshLod &lod = mesh.lods[std::min(lodLevel, mesh.lods.size() - 1)];
+    offset = lod.indexOffset;
+    count = lod.indexCount;
+  }
+  const GeometryRange &geometry = mesh.geometry;
+  size_t indexSize = geometry.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t)
+                                                             : sizeof(uint32_t);
+  BindGeometry(geometry);
+  glDrawElementsBaseVertex(
+      GL_TRIANGLES, static_cast<GLsizei>(count), geometry.indexType,
+      reinterpret_cast<const void *>((geometry.firstIndex + offset) *
+                                     indexSize),
+      static_cast<GLint>(geometry.baseVertex));
 }
 
-void SetupMesh(Mesh &mesh) {
-  // Cria VAO e VBO e envia os dados
-  glGenVertexArrays(1, &mesh.vao);
-  glGenBuffers(1, &mesh.vbo);
-  glBindVertexArray(mesh.vao);
-  glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
-  glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Vertex),
-               mesh.vertices.data(), GL_STATIC_DRAW);
-
-  // Configura atributos: posição, normal e texcoord
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
-  glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                        (void *)(offsetof(Vertex, normal)));
-  glEnableVertexAttribArray(2);
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                        (void *)(offsetof(Vertex, texCoord)));
-
-  glBindVertexArray(0);
-}
-
-GLuint LoadTexture2D(const std::string &path) {
-  // Carrega imagem com stb_image
-  int width = 0;
-  int height = 0;
-  int channels = 0;
-  stbi_set_flip_vertically_on_load(1);
-  stbi_uc *data =
-      stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
-  if (!data) {
-    std::cerr << "Falha ao carregar textura: " << path << "\n";
-    return 0;
-  }
-
-  // Cria e configura textura no OpenGL
-  GLuint texture = 0;
-  glGenTextures(1, &texture);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
-               GL_UNSIGNED_BYTE, data);
-  glGenerateMipmap(GL_TEXTURE_2D);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                  GL_LINEAR_MIPMAP_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  stbi_image_free(data);
-  return texture;
-}
-
-void SetupTextures(Model &model) {
-  // Carrega as texturas de cada material
-  for (auto &entry : model.materials) {
-    Material &material = entry.second;
-    if (!material.mapKd.empty()) {
-      material.textureId = LoadTexture2D(material.mapKd);
-      material.hasTexture = (material.textureId != 0);
+void DrawMeshInstanced(const Mesh &mesh, size_t lodLevel, size_t firstInstance,
+                       size_t instanceCount) {
+  uint32_t offset = 0;
+  uint32_t count = mesh.geometry.indexCount;
+  if (!mesh.lods.empty()) {
+    const MeshLod &lod = mesh.lods[std::min(lodLevel, mesh.lods.size() - 1)];
+    offset = lod.indexOffset;
+    count = lod.indexCount;
+  }
+  const GeometryRange &geometry = mesh.geometry;
+  size_t indexSize = geometry.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t)
+                                                             : sizeof(uint32_t);
+  BindInstancedGeometry(geometry, firstInstance);
+  glDrawElementsInstancedBaseVertex(
+      GL_TRIANGLES, static_cast<GLsizei>(count), geometry.indexType,
+      reinterpret_cast<const void *>((geometry.firstIndex + offset) *
+                                     indexSize),
+      static_cast<GLsizei>(instanceCount),
+      static_cast<GLint>(geometry.baseVertex));
+}
+
+std::vector<TextureGroup> PlanTextureGroups(const Model &model) {
+  // Imagens distintas, pela ordem dos materiais, agrupadas pelo lado da
+  // camada: potência de 2 mais próxima (em log2) da média geométrica
+  std::map<int, std::vector<std::string>> bySize;
+  std::unordered_set<std::string> seen;
+  for (const std::string &name : UsedMaterialNames(model)) {
+    const std::string &path = model.materials.at(name).mapKd;
+    if (path.empty() || !seen.insert(path).second) {
+      continue;
     }
+    int width = 0;
+    int height = 0;
+    if (!ReadImageSize(path, width, height)) {
+      std::cerr << "Textura ignorada (ilegivel): " << path << std::endl;
+      continue;
+    }
+    double side = std::sqrt(static_cast<double>(width) * height);
+    int exponent = static_cast<int>(std::lround(std::log2(side)));
+    int layerSize = 1 << std::clamp(exponent, 4, 12);
+    bySize[layerSize].push_back(path);
+  }
+
+  // Grupos a mais: o mais pequeno é ampliado para o tamanho seguinte
+  while (bySize.size() > static_cast<size_t>(kMaxTextureGroups)) {
+    auto smallest = bySize.begin();
+    auto &next = std::next(smallest)->second;
+    next.insert(next.begin(), smallest->second.begin(), smallest->second.end());
+    bySize.erase(smallest);
+  }
+
+  std::vector<TextureGroup> groups;
+  for (auto &entry : bySize) {
+    TextureGroup group;
+    group.layerSize = entry.first;
+    group.paths = std::move(entry.second);
+    groups.push_back(std::move(group));
   }
+  return groups;
 }
 
-void CleanupModel(Model &model) {
-  // Liberta buffers dos meshes
-  for (auto &mesh : model.meshes) {
-    if (mesh.vbo) {
-      glDeleteBuffers(1, &mesh.vbo);
-      mesh.vbo = 0;
+void SetupMaterials(Model &model) {
+  // Um array partilhado por grupo, em BC1 e em streaming: o modelo pode ser
+  // desenhado já, os mips chegam nos frames seguintes. Imagens que outro
+  // modelo já carregou com o mesmo lado reutilizam a camada dele
+  TextureOptions options;
+  options.compress = true;
+  options.stream = true;
+  std::unordered_map<std::string, std::pair<int, int>> layers;
+  for (const TextureGroup &group : PlanTextureGroups(model)) {
+    ArrayLayers acquired =
+        AcquireArrayLayers(group.paths, group.layerSize, options);
+    if (!acquired.texture) {
+      continue;
     }
-    if (mesh.vao) {
-      glDeleteVertexArrays(1, &mesh.vao);
-      mesh.vao = 0;
+    int g = static_cast<int>(model.textureArrays.size());
+    model.textureArrays.push_back(acquired.texture);
+    for (size_t i = 0; i < group.paths.size(); ++i) {
+      layers[group.paths[i]] = {g, acquired.layers[i]};
     }
+    model.textureLayers.push_back(std::move(acquired.layers));
   }
 
-  // Liberta texturas dos materiais
-  for (auto &entry : model.materials) {
-    if (entry.second.textureId) {
-      glDeleteTextures(1, &entry.second.textureId);
-      entry.second.textureId = 0;
-      entry.second.hasTexture = false;
+  // Entrada 0 para meshes sem material (e para os que não couberem)
+  std::vector<GpuMaterial> entries(kMaxMaterials);
+  entries[0] = GpuMaterial{{0.6f, 0.6f, 0.6f, 1.0f}, {-1, 0, 0, 0}};
+  int count = 1;
+  for (const std::string &name : UsedMaterialNames(model)) {
+    Material &material = model.materials.at(name);
+    auto layer = layers.find(material.mapKd);
+    if (layer != layers.end()) {
+      material.textureGroup = layer->second.first;
+      material.textureLayer = layer->second.second;
+    }
+    if (count == kMaxMaterials) {
+      std::cerr << "Materiais a mais no modelo, " << name
+                << " usa a cor base" << std::endl;
+      material.index = 0;
+      continue;
     }
+    material.index = count++;
+    entries[material.index] = GpuMaterial{
+        {material.kd.x, material.kd.y, material.kd.z, 1.0f},
+        {material.textureGroup, material.textureLayer,
+         material.textureGroup >= 0 ? 1 : 0, 0}};
+  }
+  for (auto &mesh : model.meshes) {
+    auto it = model.materials.find(mesh.materialName);
+    mesh.materialIndex = it != model.materials.end() ? it->second.index : 0;
+  }
+
+  glGenBuffers(1, &model.materialBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, model.materialBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, entries.size() * sizeof(GpuMaterial),
+               entries.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  TrackGpuBuffer(model.materialBuffer, entries.size() * sizeof(GpuMaterial),
+                 "materiais");
+}
+
+void BindModelMaterials(const Model &model) {
+  for (size_t i = 0; i < model.textureArrays.size(); ++i) {
+    TouchGpuTexture(model.textureArrays[i]);
+    glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
+    glBindTexture(GL_TEXTURE_2D_ARRAY, model.textureArrays[i]);
+  }
+  glActiveTexture(GL_TEXTURE0);
+  glBindBufferBase(GL_UNIFORM_BUFFER, kMaterialBinding, model.materialBuffer);
+}
+
+void SetupMaterialProgram(GLuint program) {
+  GLuint block = glGetUniformBlockIndex(program, "Materials");
+  if (block != GL_INVALID_INDEX) {
+    glUniformBlockBinding(program, block, kMaterialBinding);
+  }
+  // Cada array na unidade com o seu número de grupo
+  GLint location = glGetUniformLocation(program, "uTextureArrays");
+  if (location >= 0) {
+    const GLint units[kMaxTextureGroups] = {0, 1, 2, 3};
+    glUseProgram(program);
+    glUniform1iv(location, kMaxTextureGroups, units);
+  }
+}
+
+void CleanupModel(Model &model) {
+  // Devolve o espaço dos meshes aos buffers partilhados
+  for (auto &mesh : model.meshes) {
+    FreeGeometry(mesh.geometry);
+  }
+
+  // Devolve as camadas ao cache (o último dono apaga o array) e apaga o UBO
+  for (size_t i = 0; i < model.textureArrays.size(); ++i) {
+    ReleaseArrayLayers(model.textureArrays[i], model.textureLayers[i]);
+  }
+  model.textureArrays.clear();
+  model.textureLayers.clear();
+  if (model.materialBuffer) {
+    UntrackGpuBuffer(model.materialBuffer);
+    glDeleteBuffers(1, &model.materialBuffer);
+    model.materialBuffer = 0;
+  }
+  for (auto &entry : model.materials) {
+    entry.second.textureGroup = -1;
+    entry.second.textureLayer = 0;
   }
 }
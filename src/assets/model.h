@@ -2,10 +2,12 @@
 
 #include <GL/glew.h>
 
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "assets/geometry_buffer.h"
 #include "math.h"
 
 struct Vertex {
@@ -17,6 +19,15 @@ struct Vertex {
   Vec2 texCoord;
 };
 
+struct CompactVertex {
+  // Posição unorm16 relativa à AABB do modelo (4º valor é padding)
+  uint16_t position[4];
+  // Normal codificada em octaedro (snorm16)
+  int16_t normal[2];
+  // Coordenada de textura em half-float
+  uint16_t texCoord[2];
+};
+
 struct Material {
   // Nome do material no ficheiro MTL
   std::string name;
@@ -24,20 +35,42 @@ struct Material {
   Vec3 kd = {0.6f, 0.6f, 0.6f};
   // Caminho da textura (map_Kd)
   std::string mapKd;
-  // ID da textura no OpenGL
-  GLuint textureId = 0;
-  // Indica se tem textura válida
-  bool hasTexture = false;
+  // Array de texturas do modelo (-1 = sem textura) e camada dentro dele
+  int textureGroup = -1;
+  int textureLayer = 0;
+  // Posição no UBO de materiais do modelo
+  int index = 0;
+};
+
+struct MeshLod {
+  // Primeiro índice e número de índices do nível dentro do EBO
+  uint32_t indexOffset = 0;
+  uint32_t indexCount = 0;
+  // Erro geométrico do nível (unidades do modelo normalizado)
+  float error = 0.0f;
 };
 
 struct Mesh {
   // Material usado por este mesh
   std::string materialName;
-  // Lista de vértices
+  // Lista de vértices únicos
   std::vector<Vertex> vertices;
-  // VAO e VBO para desenhar
-  GLuint vao = 0;
-  GLuint vbo = 0;
+  // Índices dos triângulos (3 por triângulo) para vertices
+  std::vector<uint32_t> indices;
+  // Índices dos níveis simplificados (no EBO logo a seguir a indices)
+  std::vector<uint32_t> lodIndices;
+  // Níveis de detalhe; o 0 é indices completo
+  std::vector<MeshLod> lods;
+  // AABB e esfera envolvente no espaço do modelo (culling e LOD)
+  Vec3 boundsMin = {0.0f, 0.0f, 0.0f};
+  Vec3 boundsMax = {0.0f, 0.0f, 0.0f};
+  Vec3 boundsCenter = {0.0f, 0.0f, 0.0f};
+  float boundsRadius = 0.0f;
+  // Espaço nos buffers partilhados (VAO/VBO/EBO comuns a todos os meshes
+  // com o mesmo formato); índices de todos os níveis, relativos ao mesh
+  GeometryRange geometry;
+  // Entrada no UBO de materiais (uniform uMaterial no draw)
+  int materialIndex = 0;
 };
 
 struct Model {
@@ -51,15 +84,109 @@ struct Model {
   float scale = 1.0f;
   // Y mínimo após escalar (útil para alinhar ao chão)
   float minY = 0.0f;
+  // AABB dos vértices já centrados e escalados
+  Vec3 boundsMin = {0.0f, 0.0f, 0.0f};
+  Vec3 boundsMax = {0.0f, 0.0f, 0.0f};
+  // Arrays de texturas (um por tamanho de camada, partilhados pelo cache
+  // de texturas), camadas que o modelo ocupa em cada um e UBO dos materiais
+  std::vector<GLuint> textureArrays;
+  std::vector<std::vector<int>> textureLayers;
+  GLuint materialBuffer = 0;
+};
+
+// Limites do shader: sampler2DArray uTextureArrays[4] (em GLSL 3.30 só
+// indexável por constante) e Material uMaterials[64] no bloco Materials
+const int kMaxTextureGroups = 4;
+const int kMaxMaterials = 64;
+// Ponto de ligação do bloco Materials
+const GLuint kMaterialBinding = 0;
+
+struct TextureGroup {
+  // Lado das camadas (potência de 2)
+  int layerSize = 0;
+  // Imagens do grupo; a posição é a camada
+  std::vector<std::string> paths;
+};
+
+struct ObjLoadConfig {
+  // Threads usadas no parse (0 = automático pelo tamanho do ficheiro)
+  unsigned threadCount = 0;
+  // Usa/gera o cache binário (.pmesh) ao lado do OBJ
+  bool useCache = true;
+  // Reordena triângulos/vértices para a cache da GPU e overdraw
+  bool optimizeMeshes = true;
+  // Escreve o ACMR/ATVR antes e depois da reordenação (diagnóstico)
+  bool reportOptimization = false;
+  // Gera níveis de LOD simplificados para cada mesh
+  bool generateLods = true;
+  // Máximo de triângulos por cluster: meshes maiores são divididos no
+  // espaço (k-d pelos centróides) para poderem ser recortados por partes
+  size_t clusterTriangles = 4096;
+  // Escreve a memória temporária, final e o pico de RSS de cada modelo
+  // (diagnóstico; os valores também chegam por ObjLoadStats)
+  bool reportMemory = false;
+};
+
+struct ModelUploadConfig {
+  // Formato de vértice compacto (16 bytes), quantizado pela AABB do modelo
+  bool compactVertices = false;
+  // Só a GPU fica com a geometria: depois de extrair o que for preciso (ex.:
+  // colisão) chama-se ReleaseCpuGeometry
+  bool gpuResident = false;
+};
+
+struct ObjLoadStats {
+  // Máximo de memória temporária do loader (arenas de parse e de meshes)
+  size_t transientPeakBytes = 0;
+  // Memória final dos meshes em CPU (vértices, índices e LODs)
+  size_t finalBytes = 0;
+  // Pico de RSS do processo no fim do carregamento (0 se indisponível):
+  // desde o arranque, o loader não repõe a medição
+  size_t peakResidentBytes = 0;
+  // Veio do cache .pmesh (sem parse)
+  bool fromCache = false;
 };
 
-// Carrega um ficheiro OBJ e preenche a estrutura Model
-bool LoadObj(const std::string &path, Model &model);
-// Cria buffers OpenGL para um mesh
+// Carrega um ficheiro OBJ e preenche a estrutura Model; stats recebe a
+// memória usada no carregamento
+bool LoadObj(const std::string &path, Model &model,
+             const ObjLoadConfig &config = {}, ObjLoadStats *stats = nullptr);
+// Lê os materiais de um ficheiro MTL (acrescenta aos que já existem)
+bool LoadMtl(const std::string &path,
+             std::unordered_map<std::string, Material> &materials);
+// Centra o modelo na origem, escala-o para tamanho 1 e recalcula os
+// volumes envolventes dos meshes (LoadObj já o faz)
+void NormalizeModel(Model &model);
+// Memória de CPU ocupada pelos meshes do modelo
+size_t ModelMemoryBytes(const Model &model);
+// Calcula a AABB e a esfera envolvente do mesh a partir dos vértices
+void ComputeMeshBounds(Mesh &mesh);
+// Copia vértices e índices do mesh para os buffers partilhados
 void SetupMesh(Mesh &mesh);
-// Carrega uma textura 2D a partir de um ficheiro
-GLuint LoadTexture2D(const std::string &path);
-// Carrega e associa texturas aos materiais
-void SetupTextures(Model &model);
-// Liberta recursos do modelo (VAO/VBO/texturas)
+// Igual a SetupMesh mas no formato compacto, quantizado pela AABB do modelo
+void SetupMeshCompact(Mesh &mesh, const Vec3 &boundsMin,
+                      const Vec3 &boundsMax);
+// Envia todos os meshes do modelo para os buffers partilhados
+void UploadModel(Model &model, const ModelUploadConfig &config);
+// Larga os vértices e índices em CPU de um modelo já enviado; continua a
+// poder ser desenhado (intervalos e LODs ficam), mas não serve para colisão
+void ReleaseCpuGeometry(Model &model);
+// Desenha um nível de LOD do mesh (glDrawElementsBaseVertex no bloco
+// partilhado; o VAO só é ligado quando muda)
+void DrawMesh(const Mesh &mesh, size_t lodLevel = 0);
+// Igual a DrawMesh para instanceCount instâncias a partir de firstInstance
+// no buffer de instâncias (UploadInstances)
+void DrawMeshInstanced(const Mesh &mesh, size_t lodLevel, size_t firstInstance,
+                       size_t instanceCount);
+// Agrupa por tamanho as texturas dos materiais usados pelos meshes (no
+// máximo kMaxTextureGroups; as que sobram juntam-se ao grupo maior seguinte)
+std::vector<TextureGroup> PlanTextureGroups(const Model &model);
+// Obtém as camadas nos arrays de texturas do cache (BC1 em streaming,
+// geridos pelo orçamento de VRAM) e cria o UBO dos materiais usados, e atribui a cada mesh a sua entrada
+void SetupMaterials(Model &model);
+// Liga os arrays às unidades 0..3 e o UBO ao bloco Materials
+void BindModelMaterials(const Model &model);
+// Liga o bloco Materials e os samplers uTextureArrays de um programa
+void SetupMaterialProgram(GLuint program);
+// Liberta recursos do modelo (espaço nos buffers, camadas dos arrays e UBO)
 void CleanupModel(Model &model);
@@ -0,0 +1,263 @@
+#include "assets/residency.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+// Frames sem uso a partir dos quais uma textura pode ser largada (menus
+// durante o jogo, modelos que saíram de cena)
+const uint64_t kEvictIdleFrames = 120;
+// Só devolve qualidade se o total estimado ficar abaixo desta fração do
+// orçamento (evita reduzir e restaurar em frames alternados)
+const double kRestoreHeadroom = 0.9;
+
+struct GpuTexture {
+  size_t bytes = 0;
+  std::string label;
+  // Sem reloader a textura só é contada
+  TextureReloader reloader;
+  // Último frame em que foi ligada
+  uint64_t lastUsed = 0;
+  // Níveis retirados (0 = completa) ou kTextureEvicted
+  int dropLevels = 0;
+  // Não há versão mais pequena do que a atual
+  bool atMinimum = false;
+};
+
+struct GpuBuffer {
+  size_t bytes = 0;
+  const char *label = "";
+};
+
+// Recursos registados e totais; só usados na thread de GL
+std::unordered_map<GLuint, GpuTexture> gTextures;
+std::unordered_map<GLuint, GpuBuffer> gBuffers;
+size_t gTextureBytes = 0;
+size_t gBufferBytes = 0;
+size_t gBudget = 0;
+uint64_t gFrame = 0;
+VramUsage gCounters;
+
+size_t TotalBytes() { return gTextureBytes + gBufferBytes; }
+
+// Pede ao dono da textura outra qualidade; o tamanho novo chega por
+// TrackGpuTexture durante o upload
+bool ApplyQuality(GLuint id, GpuTexture &texture, int dropLevels) {
+  if (!texture.reloader(id, dropLevels)) {
+    texture.atMinimum = true;
+    return false;
+  }
+  if (dropLevels == kTextureEvicted) {
+    ++gCounters.evictions;
+  } else if (texture.dropLevels == kTextureEvicted ||
+             dropLevels < texture.dropLevels) {
+    ++gCounters.restores;
+  } else {
+    ++gCounters.downscales;
+  }
+  if (dropLevels == kTextureEvicted || dropLevels < texture.dropLevels) {
+    texture.atMinimum = false;
+  }
+  texture.dropLevels = dropLevels;
+  return true;
+}
+
+// Texturas geridas ainda carregadas: as usadas há mais tempo primeiro e,
+// entre essas, as maiores
+std::vector<GLuint> EvictionOrder() {
+  std::vector<GLuint> order;
+  for (const auto &entry : gTextures) {
+    if (entry.second.reloader &&
+        entry.second.dropLevels != kTextureEvicted) {
+      order.push_back(entry.first);
+    }
+  }
+  std::sort(order.begin(), order.end(), [](GLuint a, GLuint b) {
+    const GpuTexture &ta = gTextures[a];
+    const GpuTexture &tb = gTextures[b];
+    if (ta.lastUsed != tb.lastUsed) {
+      return ta.lastUsed < tb.lastUsed;
+    }
+    return ta.bytes > tb.bytes;
+  });
+  return order;
+}
+
+double Megabytes(size_t bytes) { return bytes / (1024.0 * 1024.0); }
+}
+
+void TrackGpuTexture(GLuint texture, size_t bytes) {
+  if (!texture) {
+    return;
+  }
+  auto inserted = gTextures.try_emplace(texture);
+  GpuTexture &entry = inserted.first->second;
+  if (inserted.second) {
+    entry.lastUsed = gFrame;
+  }
+  gTextureBytes = gTextureBytes - entry.bytes + bytes;
+  entry.bytes = bytes;
+}
+
+void TrackGpuBuffer(GLuint buffer, size_t bytes, const char *label) {
+  if (!buffer) {
+    return;
+  }
+  GpuBuffer &entry = gBuffers[buffer];
+  gBufferBytes = gBufferBytes - entry.bytes + bytes;
+  entry.bytes = bytes;
+  entry.label = label;
+}
+
+void UntrackGpuTexture(GLuint texture) {
+  auto it = gTextures.find(texture);
+  if (it != gTextures.end()) {
+    gTextureBytes -= it->second.bytes;
+    gTextures.erase(it);
+  }
+}
+
+void UntrackGpuBuffer(GLuint buffer) {
+  auto it = gBuffers.find(buffer);
+  if (it != gBuffers.end()) {
+    gBufferBytes -= it->second.bytes;
+    gBuffers.erase(it);
+  }
+}
+
+void SetTextureReloader(GLuint texture, const std::string &label,
+                        TextureReloader reloader) {
+  if (!texture) {
+    return;
+  }
+  auto inserted = gTextures.try_emplace(texture);
+  GpuTexture &entry = inserted.first->second;
+  if (inserted.second) {
+    entry.lastUsed = gFrame;
+  }
+  entry.label = label;
+  entry.reloader = std::move(reloader);
+}
+
+void TouchGpuTexture(GLuint texture) {
+  auto it = gTextures.find(texture);
+  if (it == gTextures.end()) {
+    return;
+  }
+  it->second.lastUsed = gFrame;
+  // Precisa dela: volta completa em streaming, com a 1x1 até chegar (o
+  // orçamento reduz depois se faltar)
+  if (it->second.dropLevels == kTextureEvicted) {
+    ApplyQuality(texture, it->second, 0);
+  }
+}
+
+void SetVramBudget(size_t bytes) { gBudget = bytes; }
+
+void UpdateVramBudget() {
+  ++gFrame;
+  if (gBudget == 0) {
+    return;
+  }
+
+  if (TotalBytes() > gBudget) {
+    std::vector<GLuint> order = EvictionOrder();
+    // Primeiro larga as que não são usadas há muito
+    for (GLuint id : order) {
+      if (TotalBytes() <= gBudget) {
+        return;
+      }
+      GpuTexture &texture = gTextures[id];
+      if (gFrame - texture.lastUsed >= kEvictIdleFrames) {
+        ApplyQuality(id, texture, kTextureEvicted);
+      }
+    }
+    // Depois reduz as restantes para metade (uma vez por frame cada)
+    for (GLuint id : order) {
+      if (TotalBytes() <= gBudget) {
+        return;
+      }
+      GpuTexture &texture = gTextures[id];
+      if (texture.dropLevels != kTextureEvicted && !texture.atMinimum) {
+        ApplyQuality(id, texture, texture.dropLevels + 1);
+      }
+    }
+    return;
+  }
+
+  // Com folga: devolve um nível à reduzida usada mais recentemente, se o
+  // dobro do lado (4x os bytes) ainda couber
+  GLuint best = 0;
+  for (const auto &entry : gTextures) {
+    if (entry.second.reloader && entry.second.dropLevels > 0 &&
+        (!best || entry.second.lastUsed > gTextures[best].lastUsed)) {
+      best = entry.first;
+    }
+  }
+  if (best) {
+    GpuTexture &texture = gTextures[best];
+    size_t estimated = TotalBytes() - texture.bytes + texture.bytes * 4;
+    if (estimated <= gBudget * kRestoreHeadroom) {
+      ApplyQuality(best, texture, texture.dropLevels - 1);
+    }
+  }
+}
+
+VramUsage GetVramUsage() {
+  VramUsage usage = gCounters;
+  usage.textureBytes = gTextureBytes;
+  usage.bufferBytes = gBufferBytes;
+  usage.budgetBytes = gBudget;
+  usage.textures = gTextures.size();
+  usage.buffers = gBuffers.size();
+  for (const auto &entry : gTextures) {
+    if (entry.second.dropLevels == kTextureEvicted) {
+      ++usage.evictedTextures;
+    } else if (entry.second.dropLevels > 0) {
+      ++usage.downscaledTextures;
+    }
+  }
+  return usage;
+}
+
+void PrintVramUsage(std::ostream &out, size_t maxEntries) {
+  VramUsage usage = GetVramUsage();
+  out << std::fixed << std::setprecision(2) << "VRAM: "
+      << Megabytes(usage.textureBytes) << " MB em " << usage.textures
+      << " texturas, " << Megabytes(usage.bufferBytes) << " MB em "
+      << usage.buffers << " buffers";
+  if (usage.budgetBytes) {
+    out << " (orcamento " << Megabytes(usage.budgetBytes) << " MB)";
+  }
+  out << "\n";
+
+  // Maiores recursos, texturas e buffers juntos
+  std::vector<std::pair<size_t, std::string>> entries;
+  for (const auto &entry : gTextures) {
+    std::string label = entry.second.label.empty()
+                            ? "textura " + std::to_string(entry.first)
+                            : entry.second.label;
+    if (entry.second.dropLevels == kTextureEvicted) {
+      label += " [largada]";
+    } else if (entry.second.dropLevels > 0) {
+      label += " [1/" + std::to_string(1 << entry.second.dropLevels) + "]";
+    }
+    entries.emplace_back(entry.second.bytes, std::move(label));
+  }
+  for (const auto &entry : gBuffers) {
+    entries.emplace_back(entry.second.bytes,
+                         std::string(entry.second.label) + " " +
+                             std::to_string(entry.first));
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const auto &a, const auto &b) { return a.first > b.first; });
+  for (size_t i = 0; i < entries.size() && i < maxEntries; ++i) {
+    out << "  " << Megabytes(entries[i].first) << " MB  " << entries[i].second
+        << "\n";
+  }
+  out << std::defaultfloat;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+
+// Qualidade pedida ao TextureReloader: níveis de mip retirados do topo
+// (cada um divide o lado por 2); kTextureEvicted = só a versão 1x1
+const int kTextureEvicted = -1;
+
+// Refaz o conteúdo da textura (mesmo id) com dropLevels níveis a menos, ou
+// 1x1 com kTextureEvicted. Não deve descodificar na hora: os níveis podem
+// chegar por streaming (até lá fica o conteúdo atual). Devolve false se
+// essa qualidade não existir (ex.: já está no tamanho mínimo). Thread de GL
+using TextureReloader = std::function<bool(GLuint texture, int dropLevels)>;
+
+struct VramUsage {
+  // Bytes estimados em texturas e buffers registados
+  size_t textureBytes = 0;
+  size_t bufferBytes = 0;
+  // Limite configurado (0 = sem limite)
+  size_t budgetBytes = 0;
+  size_t textures = 0;
+  size_t buffers = 0;
+  // Texturas geridas que estão reduzidas ou largadas neste momento
+  size_t downscaledTextures = 0;
+  size_t evictedTextures = 0;
+  // Totais desde o arranque
+  size_t downscales = 0;
+  size_t evictions = 0;
+  size_t restores = 0;
+};
+
+// Regista (ou atualiza) o tamanho de uma textura ou buffer na GPU
+void TrackGpuTexture(GLuint texture, size_t bytes);
+void TrackGpuBuffer(GLuint buffer, size_t bytes, const char *label);
+// Esquece o recurso (chamar junto do glDelete*)
+void UntrackGpuTexture(GLuint texture);
+void UntrackGpuBuffer(GLuint buffer);
+// Deixa a textura ser reduzida ou largada quando o orçamento for excedido;
+// label aparece no relatório
+void SetTextureReloader(GLuint texture, const std::string &label,
+                        TextureReloader reloader);
+// Marca a textura como usada neste frame; se estiver largada pede já a
+// versão completa, que chega por streaming (chamar antes de a ligar)
+void TouchGpuTexture(GLuint texture);
+// Limite de VRAM para texturas e buffers (0 = sem limite)
+void SetVramBudget(size_t bytes);
+// Uma vez por frame na thread de GL: acima do orçamento larga as texturas
+// sem uso há mais tempo e depois reduz as restantes (menos usadas
+// primeiro); com folga devolve a qualidade a uma reduzida por frame
+void UpdateVramBudget();
+// Totais atuais (para diagnóstico)
+VramUsage GetVramUsage();
+// Escreve os totais e os maiores recursos
+void PrintVramUsage(std::ostream &out, size_t maxEntries = 8);
@@ -0,0 +1,590 @@
+#include "assets/texture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <memory>
+
+#include "assets/asset_archive.h"
+#include "assets/residency.h"
+#include "assets/thread_pool.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+bool DecodeImage(const std::string &path, DecodedImage &image) {
+  // A flag de flip é por thread (a versão global não é thread-safe)
+  stbi_set_flip_vertically_on_load_thread(1);
+  // Descodifica diretamente da vista do arquivo (ou do ficheiro mapeado)
+  MappedFile file;
+  if (OpenAsset(path, file) && file.size > 0) {
+    int channels = 0;
+    image.pixels = stbi_load_from_memory(
+        reinterpret_cast<const stbi_uc *>(file.data),
+        static_cast<int>(file.size), &image.width, &image.height, &channels,
+        STBI_rgb_alpha);
+  }
+  UnmapFile(file);
+  if (!image.pixels) {
+    std::cerr << "Falha ao carregar textura: " << path << "\n";
+    return false;
+  }
+  return true;
+}
+
+bool ReadImageSize(const std::string &path, int &width, int &height) {
+  MappedFile file;
+  int channels = 0;
+  bool ok = OpenAsset(path, file) && file.size > 0 &&
+            stbi_info_from_memory(reinterpret_cast<const stbi_uc *>(file.data),
+                                  static_cast<int>(file.size), &width, &height,
+                                  &channels);
+  UnmapFile(file);
+  return ok;
+}
+
+bool DecodeTextureLayer(const std::string &path, int layerSize, bool compress,
+                        MipChain &out) {
+  // Cache da variante reamostrada (a da imagem original não serve)
+  std::string variant = "." + std::to_string(layerSize);
+  if (compress && LoadCompressedCache(path, out, variant)) {
+    return true;
+  }
+
+  DecodedImage image;
+  bool ok = DecodeImage(path, image);
+  std::vector<unsigned char> pixels;
+  if (ok) {
+    ResizeImage(image.pixels, image.width, image.height, layerSize,
+                layerSize, pixels);
+  } else {
+    // Camada cinzenta: o resto do array continua utilizável
+    pixels.assign(static_cast<size_t>(layerSize) * layerSize * 4, 128);
+  }
+  FreeDecodedImage(image);
+  // Alfa a 255: o compressor escolhe BC1 e todas as camadas ficam iguais
+  for (size_t i = 3; i < pixels.size(); i += 4) {
+    pixels[i] = 255;
+  }
+  if (compress) {
+    CompressTexture(pixels.data(), layerSize, layerSize, out);
+    if (ok && !AssetInArchive(path)) {
+      SaveCompressedCache(path, out, variant);
+    }
+  } else {
+    BuildMipChain(pixels.data(), layerSize, layerSize, out);
+  }
+  return ok;
+}
+
+bool DecodeCompressedImage(const std::string &path, DecodedImage &image) {
+  // Cache válido: não é preciso tocar na imagem original
+  if (LoadCompressedCache(path, image.mips)) {
+    image.width = image.mips.levels[0].width;
+    image.height = image.mips.levels[0].height;
+    return true;
+  }
+
+  // Primeira vez (ou imagem alterada): comprime e grava para a próxima
+  if (!DecodeImage(path, image)) {
+    return false;
+  }
+  CompressTexture(image.pixels, image.width, image.height, image.mips);
+  if (!AssetInArchive(path)) {
+    SaveCompressedCache(path, image.mips);
+  }
+  stbi_image_free(image.pixels);
+  image.pixels = nullptr;
+  return true;
+}
+
+void FreeDecodedImage(DecodedImage &image) {
+  if (image.pixels) {
+    stbi_image_free(image.pixels);
+  }
+  image = DecodedImage{};
+}
+
+namespace {
+struct TextureStream {
+  // Textura provisória que vai recebendo os níveis
+  GLuint texture = 0;
+  GLenum target = GL_TEXTURE_2D;
+  std::unique_ptr<DecodedImage> image;
+  std::future<void> decoded;
+  // Próximo nível a enviar (começa no mais pequeno); -1 = ainda nenhum
+  int nextLevel = -1;
+  bool cancelled = false;
+};
+
+// Streams em curso; só usados na thread de GL
+std::vector<std::unique_ptr<TextureStream>> gStreams;
+
+// Escolhe entre BC (com cache .ptex) e RGBA8 conforme o pedido
+void DecodeForUpload(const std::string &path, DecodedImage &image,
+                     bool useCompressed) {
+  if (useCompressed) {
+    DecodeCompressedImage(path, image);
+  } else {
+    DecodeImage(path, image);
+  }
+}
+
+// Imagem para streaming: mips sempre prontos (o worker gera-os também para
+// RGBA8), sem os pixels originais
+void DecodeStreamImage(const std::string &path, DecodedImage &image,
+                       bool useCompressed) {
+  DecodeForUpload(path, image, useCompressed);
+  if (image.pixels && image.mips.levels.empty()) {
+    BuildMipChain(image.pixels, image.width, image.height, image.mips);
+    stbi_image_free(image.pixels);
+    image.pixels = nullptr;
+  }
+}
+
+void SetTextureParameters(GLenum target) {
+  glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+// Envia bytes para a textura ligada através de um PBO; upload recebe o
+// ponteiro a usar nas chamadas glTex*Image (offset no PBO ou memória)
+template <typename Upload>
+void UploadThroughPbo(const unsigned char *pixels, size_t bytes,
+                      Upload upload) {
+  // Copia os pixels para um PBO; o driver faz a transferência sem bloquear
+  GLuint pbo = 0;
+  glGenBuffers(1, &pbo);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+  glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+  void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                  GL_MAP_WRITE_BIT |
+                                      GL_MAP_INVALIDATE_BUFFER_BIT);
+  const unsigned char *source = nullptr; // offset 0 dentro do PBO
+  if (mapped) {
+    std::memcpy(mapped, pixels, bytes);
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+  } else {
+    // Sem PBO mapeável: envia diretamente da memória do cliente
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    source = pixels;
+  }
+  upload(source);
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  glDeleteBuffers(1, &pbo);
+}
+
+// Define um nível de mip a partir de source (já no PBO ou em memória)
+void TexLevel(GLenum target, const MipChain &mips, size_t level,
+              const unsigned char *source) {
+  const MipLevel &info = mips.levels[level];
+  GLint mip = static_cast<GLint>(level);
+  GLsizei size = static_cast<GLsizei>(info.size);
+  if (target == GL_TEXTURE_2D_ARRAY) {
+    if (mips.format == GL_RGBA8) {
+      glTexImage3D(target, mip, GL_RGBA8, info.width, info.height,
+                   mips.layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, source);
+    } else {
+      glCompressedTexImage3D(target, mip, mips.format, info.width,
+                             info.height, mips.layers, 0, size, source);
+    }
+  } else if (mips.format == GL_RGBA8) {
+    glTexImage2D(target, mip, GL_RGBA8, info.width, info.height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, source);
+  } else {
+    glCompressedTexImage2D(target, mip, mips.format, info.width, info.height,
+                           0, size, source);
+  }
+}
+
+// Envia a cadeia toda (já ligada a target) e expõe todos os níveis
+void UploadMipChain(GLenum target, const MipChain &mips) {
+  UploadThroughPbo(mips.data.data(), mips.data.size(),
+                   [target, &mips](const unsigned char *source) {
+                     for (size_t level = 0; level < mips.levels.size();
+                          ++level) {
+                       TexLevel(target, mips, level,
+                                source + mips.levels[level].offset);
+                     }
+                   });
+  glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(target, GL_TEXTURE_MAX_LEVEL,
+                  static_cast<GLint>(mips.levels.size()) - 1);
+}
+
+// Textura 1x1 cinzenta (por camada) enquanto os níveis reais não chegam;
+// com texture != 0 reaproveita o id
+GLuint CreatePlaceholderTexture(GLenum target, int layers,
+                                GLuint texture = 0) {
+  std::vector<unsigned int> grey(layers, 0xff808080);
+  if (!texture) {
+    glGenTextures(1, &texture);
+  }
+  glBindTexture(target, texture);
+  if (target == GL_TEXTURE_2D_ARRAY) {
+    glTexImage3D(target, 0, GL_RGBA8, 1, 1, layers, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, grey.data());
+  } else {
+    glTexImage2D(target, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 grey.data());
+  }
+  glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 0);
+  SetTextureParameters(target);
+  TrackGpuTexture(texture, grey.size() * sizeof(unsigned int));
+  return texture;
+}
+
+// Tamanho final de um array ainda por descodificar (BC1 tem meio byte por
+// pixel; os mips somam mais um terço)
+size_t EstimateArrayBytes(int layerSize, size_t layers, bool compressed) {
+  size_t pixels = static_cast<size_t>(layerSize) * layerSize * layers;
+  size_t bytes = compressed ? pixels / 2 : pixels * 4;
+  return bytes + bytes / 3;
+}
+
+// Tira os dropLevels níveis maiores da cadeia
+void DropTopMips(MipChain &mips, int dropLevels) {
+  if (dropLevels <= 0) {
+    return;
+  }
+  size_t start = mips.levels[dropLevels].offset;
+  mips.levels.erase(mips.levels.begin(), mips.levels.begin() + dropLevels);
+  for (MipLevel &level : mips.levels) {
+    level.offset -= start;
+  }
+  mips.data.erase(mips.data.begin(), mips.data.begin() + start);
+}
+
+// Camadas de um array descodificadas em paralelo e juntadas
+void DecodeTextureArray(const std::vector<std::string> &paths, int layerSize,
+                        bool compress, MipChain &out) {
+  std::vector<MipChain> layers(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    DecodeTextureLayer(paths[i], layerSize, compress, layers[i]);
+  }
+  StackMipChains(layers, out);
+}
+
+bool IsReady(const std::future<void> &future) {
+  return future.wait_for(std::chrono::seconds(0)) ==
+         std::future_status::ready;
+}
+}
+
+GLuint UploadTexture2D(const DecodedImage &image, GLuint texture) {
+  bool hasMips = !image.mips.levels.empty();
+  if (!image.pixels && !hasMips) {
+    return 0;
+  }
+
+  // Cria (ou reaproveita) e configura textura no OpenGL
+  if (!texture) {
+    glGenTextures(1, &texture);
+  }
+  CancelTextureStream(texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  if (hasMips) {
+    // Os mips já vêm prontos: envia cada nível tal como está
+    UploadMipChain(GL_TEXTURE_2D, image.mips);
+  } else {
+    size_t bytes = static_cast<size_t>(image.width) * image.height * 4;
+    UploadThroughPbo(image.pixels, bytes,
+                     [&image](const unsigned char *source) {
+                       glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width,
+                                    image.height, 0, GL_RGBA,
+                                    GL_UNSIGNED_BYTE, source);
+                     });
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+    glGenerateMipmap(GL_TEXTURE_2D);
+  }
+  SetTextureParameters(GL_TEXTURE_2D);
+  size_t bytes = hasMips ? image.mips.data.size()
+                         : static_cast<size_t>(image.width) * image.height *
+                               4 * 4 / 3;
+  TrackGpuTexture(texture, bytes);
+  return texture;
+}
+
+GLuint LoadTexture2D(const std::string &path, const TextureOptions &options) {
+  return LoadTextures2D({path}, options)[0];
+}
+
+std::vector<GLuint> LoadTextures2D(const std::vector<std::string> &paths,
+                                   const TextureOptions &options) {
+  // O suporte a S3TC só pode ser consultado aqui, na thread de GL
+  bool useCompressed = options.compress && GLEW_EXT_texture_compression_s3tc;
+  ThreadPool &pool = SharedThreadPool();
+  std::vector<GLuint> textures(paths.size(), 0);
+
+  // Streaming: textura provisória já e mips prontos (o worker gera-os
+  // também para RGBA8) para enviar por níveis nos próximos frames
+  if (options.stream) {
+    for (size_t i = 0; i < paths.size(); ++i) {
+      auto stream = std::make_unique<TextureStream>();
+      stream->texture = CreatePlaceholderTexture(GL_TEXTURE_2D, 1);
+      stream->image = std::make_unique<DecodedImage>();
+      DecodedImage *image = stream->image.get();
+      std::string path = paths[i];
+      stream->decoded = SubmitJob(pool, [path, image, useCompressed]() {
+        DecodeStreamImage(path, *image, useCompressed);
+      });
+      textures[i] = stream->texture;
+      gStreams.push_back(std::move(stream));
+    }
+    return textures;
+  }
+
+  // Lança todas as descodificações no pool
+  std::vector<DecodedImage> images(paths.size());
+  std::vector<std::future<void>> decoded;
+  decoded.reserve(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    decoded.push_back(SubmitJob(pool, [&paths, &images, i, useCompressed]() {
+      DecodeForUpload(paths[i], images[i], useCompressed);
+    }));
+  }
+
+  // Envia cada imagem assim que estiver pronta (as restantes continuam)
+  for (size_t i = 0; i < paths.size(); ++i) {
+    decoded[i].wait();
+    textures[i] = UploadTexture2D(images[i]);
+    FreeDecodedImage(images[i]);
+  }
+  return textures;
+}
+
+GLuint LoadTextureArray(const std::vector<std::string> &paths, int layerSize,
+                        const TextureOptions &options, GLuint texture) {
+  if (paths.empty()) {
+    return 0;
+  }
+  bool useCompressed = options.compress && GLEW_EXT_texture_compression_s3tc;
+  ThreadPool &pool = SharedThreadPool();
+
+  // Streaming: um só job prepara as camadas todas (os níveis do array têm
+  // de chegar completos)
+  if (options.stream) {
+    auto stream = std::make_unique<TextureStream>();
+    stream->target = GL_TEXTURE_2D_ARRAY;
+    if (texture) {
+      // O conteúdo atual fica visível até os níveis novos o substituírem
+      CancelTextureStream(texture);
+      stream->texture = texture;
+    } else {
+      stream->texture = CreatePlaceholderTexture(
+          GL_TEXTURE_2D_ARRAY, static_cast<int>(paths.size()));
+    }
+    // Conta já com o tamanho final (o orçamento de VRAM decide com ele)
+    TrackGpuTexture(stream->texture,
+                    EstimateArrayBytes(layerSize, paths.size(), useCompressed));
+    stream->image = std::make_unique<DecodedImage>();
+    DecodedImage *image = stream->image.get();
+    stream->decoded =
+        SubmitJob(pool, [paths, layerSize, image, useCompressed]() {
+          DecodeTextureArray(paths, layerSize, useCompressed, image->mips);
+        });
+    texture = stream->texture;
+    gStreams.push_back(std::move(stream));
+    return texture;
+  }
+
+  // Síncrono: uma camada por job
+  std::vector<MipChain> layers(paths.size());
+  std::vector<std::future<void>> decoded;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    decoded.push_back(
+        SubmitJob(pool, [&paths, &layers, i, layerSize, useCompressed]() {
+          DecodeTextureLayer(paths[i], layerSize, useCompressed, layers[i]);
+        }));
+  }
+  for (auto &future : decoded) {
+    future.wait();
+  }
+  MipChain mips;
+  if (!StackMipChains(layers, mips)) {
+    return 0;
+  }
+  if (!texture) {
+    glGenTextures(1, &texture);
+  }
+  CancelTextureStream(texture);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+  UploadMipChain(GL_TEXTURE_2D_ARRAY, mips);
+  SetTextureParameters(GL_TEXTURE_2D_ARRAY);
+  TrackGpuTexture(texture, mips.data.size());
+  return texture;
+}
+
+bool UploadTextureLayer(GLuint texture, int layer, const MipChain &mips) {
+  if (mips.levels.empty() || IsTextureStreaming(texture)) {
+    return false;
+  }
+  glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+  UploadThroughPbo(
+      mips.data.data(), mips.data.size(),
+      [layer, &mips](const unsigned char *source) {
+        for (size_t level = 0; level < mips.levels.size(); ++level) {
+          const MipLevel &info = mips.levels[level];
+          GLint mip = static_cast<GLint>(level);
+          if (mips.format == GL_RGBA8) {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, mip, 0, 0, layer, info.width,
+                            info.height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                            source + info.offset);
+          } else {
+            glCompressedTexSubImage3D(
+                GL_TEXTURE_2D_ARRAY, mip, 0, 0, layer, info.width,
+                info.height, 1, mips.format, static_cast<GLsizei>(info.size),
+                source + info.offset);
+          }
+        }
+      });
+  return true;
+}
+
+bool ReloadTexture2D(const std::string &path, GLuint texture, bool compress,
+                     int dropLevels) {
+  // Lado mínimo de uma textura reduzida
+  const int kMinSide = 64;
+  if (dropLevels == kTextureEvicted) {
+    ClearTexture(texture, GL_TEXTURE_2D);
+    return true;
+  }
+  // Decide pelo cabeçalho se essa qualidade existe; a descodificação fica
+  // para o pool
+  int width = 0;
+  int height = 0;
+  if (!ReadImageSize(path, width, height)) {
+    return false;
+  }
+  int side = std::max(width, height);
+  int levels = 1;
+  while ((side >> levels) > 0) {
+    ++levels;
+  }
+  if (dropLevels >= levels ||
+      (dropLevels > 0 && (side >> dropLevels) < kMinSide)) {
+    return false;
+  }
+
+  // Em streaming como as texturas novas: o conteúdo atual (ou a 1x1 de uma
+  // largada) fica até os níveis chegarem, do mais pequeno para o maior
+  bool useCompressed = compress && GLEW_EXT_texture_compression_s3tc;
+  CancelTextureStream(texture);
+  auto stream = std::make_unique<TextureStream>();
+  stream->texture = texture;
+  stream->image = std::make_unique<DecodedImage>();
+  DecodedImage *image = stream->image.get();
+  // Conta já com o tamanho final (o orçamento de VRAM decide com ele)
+  size_t pixels = static_cast<size_t>(std::max(width >> dropLevels, 1)) *
+                  std::max(height >> dropLevels, 1);
+  size_t bytes = useCompressed ? pixels / 2 : pixels * 4;
+  TrackGpuTexture(texture, bytes + bytes / 3);
+  stream->decoded = SubmitJob(
+      SharedThreadPool(), [path, image, useCompressed, dropLevels]() {
+        DecodeStreamImage(path, *image, useCompressed);
+        if (image->mips.levels.size() > static_cast<size_t>(dropLevels)) {
+          DropTopMips(image->mips, dropLevels);
+        } else {
+          image->mips = MipChain{};
+        }
+      });
+  gStreams.push_back(std::move(stream));
+  return true;
+}
+
+void ClearTexture(GLuint texture, GLenum target, int layers) {
+  CancelTextureStream(texture);
+  CreatePlaceholderTexture(target, layers, texture);
+}
+
+void UpdateTextureStreaming(size_t byteBudget) {
+  size_t spent = 0;
+  bool uploaded = false;
+  for (size_t i = 0; i < gStreams.size();) {
+    TextureStream &stream = *gStreams[i];
+    if (!IsReady(stream.decoded)) {
+      ++i;
+      continue;
+    }
+    const MipChain &mips = stream.image->mips;
+    if (stream.cancelled || mips.levels.empty()) {
+      // Apagada entretanto, ou falhou (fica a provisória)
+      FreeDecodedImage(*stream.image);
+      gStreams.erase(gStreams.begin() + i);
+      continue;
+    }
+
+    // Do nível mais pequeno para o maior; cada nível enviado passa a ser a
+    // base, por isso a textura é sempre completa
+    if (stream.nextLevel < 0) {
+      stream.nextLevel = static_cast<int>(mips.levels.size()) - 1;
+      TrackGpuTexture(stream.texture, mips.data.size());
+    }
+    glBindTexture(stream.target, stream.texture);
+    while (stream.nextLevel >= 0) {
+      const MipLevel &info = mips.levels[stream.nextLevel];
+      if (uploaded && spent + info.size > byteBudget) {
+        break;
+      }
+      size_t level = static_cast<size_t>(stream.nextLevel);
+      GLenum target = stream.target;
+      UploadThroughPbo(mips.data.data() + info.offset, info.size,
+                       [target, &mips, level](const unsigned char *source) {
+                         TexLevel(target, mips, level, source);
+                       });
+      glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, stream.nextLevel);
+      glTexParameteri(target, GL_TEXTURE_MAX_LEVEL,
+                      static_cast<GLint>(mips.levels.size()) - 1);
+      spent += info.size;
+      uploaded = true;
+      --stream.nextLevel;
+    }
+    if (stream.nextLevel >= 0) {
+      // Orçamento esgotado: o resto fica para o próximo frame
+      break;
+    }
+    FreeDecodedImage(*stream.image);
+    gStreams.erase(gStreams.begin() + i);
+  }
+}
+
+size_t PendingTextureStreams() {
+  size_t pending = 0;
+  for (const auto &stream : gStreams) {
+    pending += stream->cancelled ? 0 : 1;
+  }
+  return pending;
+}
+
+bool IsTextureStreaming(GLuint texture) {
+  for (const auto &stream : gStreams) {
+    if (stream->texture == texture && !stream->cancelled) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void CancelTextureStream(GLuint texture) {
+  // O worker pode estar a escrever na imagem: só marca, a entrada sai
+  // quando a descodificação terminar
+  for (auto &stream : gStreams) {
+    if (stream->texture == texture) {
+      stream->cancelled = true;
+    }
+  }
+}
+
+void StopTextureStreaming() {
+  for (auto &stream : gStreams) {
+    stream->decoded.wait();
+    FreeDecodedImage(*stream->image);
+  }
+  gStreams.clear();
+}
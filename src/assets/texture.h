@@ -0,0 +1,85 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+#include "assets/texture_compress.h"
+
+struct DecodedImage {
+  // Pixels RGBA8 descodificados (linhas já invertidas para o OpenGL)
+  unsigned char *pixels = nullptr;
+  int width = 0;
+  int height = 0;
+  // Mips já preparados (BC1/BC3 ou RGBA8); têm prioridade sobre pixels
+  MipChain mips;
+};
+
+struct TextureOptions {
+  // Texturas BC1/BC3 quando o driver suporta S3TC
+  bool compress = false;
+  // Devolve logo uma textura provisória (1x1) e envia os mips reais por
+  // UpdateTextureStreaming, dos mais pequenos para os maiores
+  bool stream = false;
+};
+
+// Descodifica uma imagem para RGBA8; seguro para chamar em qualquer thread
+bool DecodeImage(const std::string &path, DecodedImage &image);
+// Lê só as dimensões da imagem (cabeçalho), sem descodificar
+bool ReadImageSize(const std::string &path, int &width, int &height);
+// Obtém a versão BC da imagem: lê o .ptex ou descodifica, comprime e grava.
+// Também seguro em qualquer thread
+bool DecodeCompressedImage(const std::string &path, DecodedImage &image);
+// Prepara uma camada de array: reamostrada para layerSize x layerSize,
+// opaca (os shaders só usam rgb) e com mips, em BC1 (com cache .ptex
+// próprio do tamanho) ou RGBA8. Em erro fica cinzenta e devolve false.
+// Seguro em qualquer thread
+bool DecodeTextureLayer(const std::string &path, int layerSize, bool compress,
+                        MipChain &out);
+// Liberta os pixels descodificados
+void FreeDecodedImage(DecodedImage &image);
+// Cria a textura a partir da imagem (via PBO) com todos os mips (os que
+// vierem preparados ou gerados pelo driver); thread de GL. Com texture != 0
+// substitui o conteúdo dessa textura em vez de criar uma nova
+GLuint UploadTexture2D(const DecodedImage &image, GLuint texture = 0);
+// Carrega uma textura 2D a partir de um ficheiro
+GLuint LoadTexture2D(const std::string &path,
+                     const TextureOptions &options = {});
+// Carrega várias texturas: descodifica em paralelo no pool de threads e
+// envia para a GPU na thread atual à medida que ficam prontas (ou, com
+// stream, devolve logo e continua em segundo plano)
+std::vector<GLuint> LoadTextures2D(const std::vector<std::string> &paths,
+                                   const TextureOptions &options = {});
+// Cria um GL_TEXTURE_2D_ARRAY com uma camada por imagem (reamostradas para
+// layerSize; descodificadas no pool). Com stream devolve logo uma versão
+// provisória e os níveis chegam por UpdateTextureStreaming. Com
+// texture != 0 substitui o conteúdo desse array (com stream mantém o
+// atual até chegarem os níveis novos)
+GLuint LoadTextureArray(const std::vector<std::string> &paths, int layerSize,
+                        const TextureOptions &options = {},
+                        GLuint texture = 0);
+// Substitui uma camada de um array já completo (mesmo formato e número de
+// níveis, ex.: DecodeTextureLayer com o lado atual); thread de GL
+bool UploadTextureLayer(GLuint texture, int layer, const MipChain &mips);
+// Volta a carregar a imagem numa textura existente sem os dropLevels mips
+// maiores (kTextureEvicted = só 1x1, na hora). A descodificação vai para o
+// pool e os níveis chegam por UpdateTextureStreaming; thread de GL. false
+// se a imagem não existir ou ficasse abaixo do tamanho mínimo
+bool ReloadTexture2D(const std::string &path, GLuint texture, bool compress,
+                     int dropLevels);
+// Troca o conteúdo por 1x1 cinzento (por camada): liberta a VRAM e o id
+// continua válido
+void ClearTexture(GLuint texture, GLenum target, int layers = 1);
+// Envia os níveis já descodificados das texturas em streaming, do mais
+// pequeno para o maior, até gastar o orçamento do frame (pelo menos um
+// nível); thread de GL, uma vez por frame
+void UpdateTextureStreaming(size_t byteBudget = 4 * 1024 * 1024);
+// Texturas que ainda não receberam todos os níveis
+size_t PendingTextureStreams();
+// A textura ainda está a receber níveis (não está completa)
+bool IsTextureStreaming(GLuint texture);
+// Deixa de enviar níveis para a textura (foi apagada ou substituída)
+void CancelTextureStream(GLuint texture);
+// Espera pelas descodificações em curso e descarta o que faltar enviar
+void StopTextureStreaming();
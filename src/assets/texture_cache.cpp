@@ -0,0 +1,269 @@
+#include "assets/texture_cache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include "assets/residency.h"
+
+namespace {
+struct CachedTexture {
+  // Id OpenGL e número de donos
+  GLuint id = 0;
+  int refs = 0;
+};
+
+// Cache indexado pelo caminho canónico, mais o índice inverso por id.
+// Só é usado na thread de GL, por isso não precisa de mutex
+std::unordered_map<std::string, CachedTexture> gTextures;
+std::unordered_map<GLuint, std::string> gTextureKeys;
+
+struct CachedArray {
+  GLuint id = 0;
+  TextureOptions options;
+  // Imagem de cada camada (caminho pedido e canónico) e número de donos;
+  // camadas sem donos ficam com a imagem até serem reutilizadas
+  std::vector<std::string> paths;
+  std::vector<std::string> keys;
+  std::vector<int> refs;
+  // Níveis retirados pelo orçamento de VRAM (kTextureEvicted = largado)
+  int dropLevels = 0;
+};
+
+// Arrays partilhados por lado da camada e compressão
+using ArrayKey = std::pair<int, bool>;
+std::map<ArrayKey, CachedArray> gArrays;
+
+// Caminho canónico para que "a/../b.png" e "b.png" partilhem a textura
+std::string CanonicalPath(const std::string &path) {
+  std::error_code ec;
+  std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+  return ec ? path : canonical.string();
+}
+
+// As versões BC e RGBA8 da mesma imagem são texturas diferentes
+std::string CacheKey(const std::string &path, bool compress) {
+  return CanonicalPath(path) + (compress ? "#bc" : "");
+}
+}
+
+namespace {
+// Refaz o conteúdo do array com as camadas atuais, na qualidade atual
+void RebuildArray(const ArrayKey &key, CachedArray &array) {
+  if (array.dropLevels == kTextureEvicted) {
+    ClearTexture(array.id, GL_TEXTURE_2D_ARRAY,
+                 static_cast<int>(array.paths.size()));
+    return;
+  }
+  LoadTextureArray(array.paths, key.first >> array.dropLevels, array.options,
+                   array.id);
+}
+
+std::map<ArrayKey, CachedArray>::iterator FindArray(GLuint texture) {
+  for (auto it = gArrays.begin(); it != gArrays.end(); ++it) {
+    if (it->second.id == texture) {
+      return it;
+    }
+  }
+  return gArrays.end();
+}
+}
+
+GLuint AcquireTexture(const std::string &path) {
+  return AcquireTextures({path})[0];
+}
+
+std::vector<GLuint> AcquireTextures(const std::vector<std::string> &paths,
+                                    const TextureOptions &options) {
+  // Separa os caminhos já em cache dos que faltam carregar (sem repetidos)
+  std::vector<std::string> keys(paths.size());
+  std::vector<std::string> missingPaths;
+  std::vector<std::string> missingKeys;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    keys[i] = CacheKey(paths[i], options.compress);
+    if (gTextures.count(keys[i])) {
+      continue;
+    }
+    gTextures[keys[i]] = CachedTexture{};
+    missingPaths.push_back(paths[i]);
+    missingKeys.push_back(keys[i]);
+  }
+
+  // Carrega as que faltam num só lote
+  std::vector<GLuint> loaded = LoadTextures2D(missingPaths, options);
+  for (size_t i = 0; i < loaded.size(); ++i) {
+    if (loaded[i] == 0) {
+      gTextures.erase(missingKeys[i]);
+      continue;
+    }
+    gTextures[missingKeys[i]].id = loaded[i];
+    gTextureKeys[loaded[i]] = missingKeys[i];
+    // Sob pressão de VRAM pode ser reduzida ou largada e voltar a ser lida
+    std::string path = missingPaths[i];
+    bool compress = options.compress;
+    SetTextureReloader(loaded[i], path,
+                       [path, compress](GLuint texture, int dropLevels) {
+                         return ReloadTexture2D(path, texture, compress,
+                                                dropLevels);
+                       });
+  }
+
+  // Uma referência por pedido
+  std::vector<GLuint> textures(paths.size(), 0);
+  for (size_t i = 0; i < paths.size(); ++i) {
+    auto it = gTextures.find(keys[i]);
+    if (it != gTextures.end()) {
+      ++it->second.refs;
+      textures[i] = it->second.id;
+    }
+  }
+  return textures;
+}
+
+GLuint FindCachedTexture(const std::string &path, bool compress) {
+  auto it = gTextures.find(CacheKey(path, compress));
+  return it == gTextures.end() ? 0 : it->second.id;
+}
+
+void ReleaseTexture(GLuint texture) {
+  auto key = gTextureKeys.find(texture);
+  if (key == gTextureKeys.end()) {
+    return;
+  }
+  auto it = gTextures.find(key->second);
+  if (--it->second.refs > 0) {
+    return;
+  }
+  // Último dono: apaga a textura e a entrada
+  CancelTextureStream(texture);
+  UntrackGpuTexture(texture);
+  glDeleteTextures(1, &texture);
+  gTextures.erase(it);
+  gTextureKeys.erase(key);
+}
+
+ArrayLayers AcquireArrayLayers(const std::vector<std::string> &paths,
+                               int layerSize, const TextureOptions &options) {
+  ArrayKey key(layerSize, options.compress);
+  CachedArray &array = gArrays[key];
+  if (!array.id) {
+    array.options = options;
+  }
+
+  // Camada da mesma imagem, senão uma livre, senão uma nova no fim
+  ArrayLayers result;
+  bool changed = false;
+  size_t oldLayers = array.paths.size();
+  for (const std::string &path : paths) {
+    std::string canonical = CanonicalPath(path);
+    size_t layer = static_cast<size_t>(
+        std::find(array.keys.begin(), array.keys.end(), canonical) -
+        array.keys.begin());
+    if (layer == array.keys.size()) {
+      layer = static_cast<size_t>(
+          std::find(array.refs.begin(), array.refs.end(), 0) -
+          array.refs.begin());
+    }
+    if (layer == array.keys.size()) {
+      array.paths.push_back(path);
+      array.keys.push_back(canonical);
+      array.refs.push_back(0);
+      changed = true;
+    } else if (array.keys[layer] != canonical) {
+      array.paths[layer] = path;
+      array.keys[layer] = canonical;
+      changed = true;
+    }
+    ++array.refs[layer];
+    result.layers.push_back(static_cast<int>(layer));
+  }
+
+  if (array.id) {
+    // O array atual não tem as camadas novas: é realocado já com todas em
+    // 1x1 cinzento antes de os materiais as usarem (as imagens chegam por
+    // streaming). Largado, o RebuildArray já o faz
+    if (array.paths.size() > oldLayers &&
+        array.dropLevels != kTextureEvicted) {
+      ClearTexture(array.id, GL_TEXTURE_2D_ARRAY,
+                   static_cast<int>(array.paths.size()));
+    }
+    if (changed) {
+      RebuildArray(key, array);
+    }
+    result.texture = array.id;
+    return result;
+  }
+
+  array.id = LoadTextureArray(array.paths, layerSize, options);
+  if (!array.id) {
+    gArrays.erase(key);
+    return {};
+  }
+  // Sob pressão de VRAM o array é refeito com camadas mais pequenas (os
+  // .ptex de cada tamanho ficam em cache) ou largado
+  SetTextureReloader(
+      array.id, "array " + std::to_string(layerSize) + " " + paths.front(),
+      [key](GLuint, int dropLevels) {
+        const int kMinLayerSize = 64;
+        auto it = gArrays.find(key);
+        if (it == gArrays.end() ||
+            (dropLevels > 0 && (key.first >> dropLevels) < kMinLayerSize)) {
+          return false;
+        }
+        it->second.dropLevels = dropLevels;
+        RebuildArray(key, it->second);
+        return true;
+      });
+  result.texture = array.id;
+  return result;
+}
+
+void ReleaseArrayLayers(GLuint texture, const std::vector<int> &layers) {
+  auto it = FindArray(texture);
+  if (it == gArrays.end()) {
+    return;
+  }
+  CachedArray &array = it->second;
+  for (int layer : layers) {
+    --array.refs[layer];
+  }
+  if (std::any_of(array.refs.begin(), array.refs.end(),
+                  [](int refs) { return refs > 0; })) {
+    return;
+  }
+  // Último dono: apaga o array e a entrada
+  CancelTextureStream(texture);
+  UntrackGpuTexture(texture);
+  glDeleteTextures(1, &texture);
+  gArrays.erase(it);
+}
+
+std::vector<CachedLayer> FindCachedLayers(const std::string &path) {
+  std::string canonical = CanonicalPath(path);
+  std::vector<CachedLayer> found;
+  for (const auto &entry : gArrays) {
+    const CachedArray &array = entry.second;
+    if (array.dropLevels == kTextureEvicted) {
+      continue;
+    }
+    for (size_t layer = 0; layer < array.keys.size(); ++layer) {
+      if (array.refs[layer] > 0 && array.keys[layer] == canonical) {
+        found.push_back(CachedLayer{array.id, static_cast<int>(layer),
+                                    entry.first.first >> array.dropLevels,
+                                    entry.first.second});
+      }
+    }
+  }
+  return found;
+}
+
+void ReloadCachedArray(GLuint texture) {
+  auto it = FindArray(texture);
+  if (it != gArrays.end()) {
+    RebuildArray(it->first, it->second);
+  }
+}
+
+size_t CachedTextureCount() { return gTextures.size() + gArrays.size(); }
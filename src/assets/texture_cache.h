@@ -0,0 +1,53 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+#include "assets/texture.h"
+
+// Obtém a textura de um ficheiro do cache partilhado (carrega se faltar);
+// cada chamada com sucesso soma uma referência. Devolve 0 em erro
+GLuint AcquireTexture(const std::string &path);
+// Versão em lote: as texturas em falta são descodificadas em paralelo.
+// Com compress, pede a versão BC (entrada separada da não comprimida); com
+// stream, as que faltam chegam por UpdateTextureStreaming
+std::vector<GLuint> AcquireTextures(const std::vector<std::string> &paths,
+                                    const TextureOptions &options = {});
+// Id da textura já em cache (sem somar referência); 0 se não estiver
+GLuint FindCachedTexture(const std::string &path, bool compress = false);
+// Larga uma referência; a textura é apagada quando não resta nenhuma
+void ReleaseTexture(GLuint texture);
+
+struct ArrayLayers {
+  // Array partilhado e camada de cada imagem pedida
+  GLuint texture = 0;
+  std::vector<int> layers;
+};
+
+struct CachedLayer {
+  // Array e camada onde a imagem está, com o lado atual (pode ter sido
+  // reduzido pelo orçamento de VRAM)
+  GLuint texture = 0;
+  int layer = 0;
+  int layerSize = 0;
+  bool compress = false;
+};
+
+// Obtém camadas para as imagens no array partilhado do lado e compressão
+// pedidos (um por par, indexado pelo caminho canónico de cada camada):
+// as que já lá estão só somam uma referência, as novas ocupam camadas
+// livres ou alargam o array. Devolve texture 0 em erro
+ArrayLayers AcquireArrayLayers(const std::vector<std::string> &paths,
+                               int layerSize,
+                               const TextureOptions &options = {});
+// Larga uma referência de cada camada; o array é apagado quando não resta
+// nenhuma
+void ReleaseArrayLayers(GLuint texture, const std::vector<int> &layers);
+// Camadas em uso com esta imagem (ignora os arrays largados da VRAM)
+std::vector<CachedLayer> FindCachedLayers(const std::string &path);
+// Volta a carregar o array inteiro na qualidade atual
+void ReloadCachedArray(GLuint texture);
+// Número de texturas vivas no cache (para diagnóstico)
+size_t CachedTextureCount();
@@ -0,0 +1,466 @@
+#include "assets/texture_compress.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "assets/asset_archive.h"
+#include "assets/cache_io.h"
+#include "assets/mapped_file.h"
+
+namespace {
+// Identificação e versão do formato .ptex
+const char kMagic[4] = {'P', 'T', 'E', 'X'};
+const uint32_t kVersion = 1;
+
+// Reduz uma imagem RGBA8 para metade com filtro de caixa 2x2 (como o
+// glGenerateMipmap); dimensões ímpares repetem a última linha/coluna
+std::vector<unsigned char> Downsample(const unsigned char *src, int width,
+                                      int height, int &outWidth,
+                                      int &outHeight) {
+  outWidth = std::max(1, width / 2);
+  outHeight = std::max(1, height / 2);
+  std::vector<unsigned char> dst(static_cast<size_t>(outWidth) * outHeight *
+                                 4);
+  for (int y = 0; y < outHeight; ++y) {
+    int y0 = std::min(y * 2, height - 1);
+    int y1 = std::min(y * 2 + 1, height - 1);
+    for (int x = 0; x < outWidth; ++x) {
+      int x0 = std::min(x * 2, width - 1);
+      int x1 = std::min(x * 2 + 1, width - 1);
+      for (int c = 0; c < 4; ++c) {
+        int sum = src[(static_cast<size_t>(y0) * width + x0) * 4 + c] +
+                  src[(static_cast<size_t>(y0) * width + x1) * 4 + c] +
+                  src[(static_cast<size_t>(y1) * width + x0) * 4 + c] +
+                  src[(static_cast<size_t>(y1) * width + x1) * 4 + c];
+        dst[(static_cast<size_t>(y) * outWidth + x) * 4 + c] =
+            static_cast<unsigned char>((sum + 2) / 4);
+      }
+    }
+  }
+  return dst;
+}
+
+// Converte RGB8 para RGB565 e de volta (com replicação de bits)
+uint16_t PackRgb565(const float rgb[3]) {
+  int r = std::clamp(static_cast<int>(rgb[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+  int g = std::clamp(static_cast<int>(rgb[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+  int b = std::clamp(static_cast<int>(rgb[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+  return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void UnpackRgb565(uint16_t packed, int rgb[3]) {
+  int r = (packed >> 11) & 31;
+  int g = (packed >> 5) & 63;
+  int b = packed & 31;
+  rgb[0] = (r << 3) | (r >> 2);
+  rgb[1] = (g << 2) | (g >> 4);
+  rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Bloco de cor BC1 (8 bytes): extremos no eixo principal da cor do bloco
+void EncodeColorBlock(const unsigned char block[16][4], unsigned char out[8]) {
+  // Média e covariância das cores
+  float mean[3] = {0.0f, 0.0f, 0.0f};
+  for (int i = 0; i < 16; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      mean[c] += block[i][c] / 16.0f;
+    }
+  }
+  float cov[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+  for (int i = 0; i < 16; ++i) {
+    float d[3] = {block[i][0] - mean[0], block[i][1] - mean[1],
+                  block[i][2] - mean[2]};
+    cov[0] += d[0] * d[0];
+    cov[1] += d[0] * d[1];
+    cov[2] += d[0] * d[2];
+    cov[3] += d[1] * d[1];
+    cov[4] += d[1] * d[2];
+    cov[5] += d[2] * d[2];
+  }
+
+  // Eixo principal por iteração de potência
+  float axis[3] = {1.0f, 1.0f, 1.0f};
+  for (int iter = 0; iter < 4; ++iter) {
+    float next[3] = {cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                     cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                     cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]};
+    float len = std::max({std::abs(next[0]), std::abs(next[1]),
+                          std::abs(next[2])});
+    if (len <= 0.0f) {
+      break;
+    }
+    for (int c = 0; c < 3; ++c) {
+      axis[c] = next[c] / len;
+    }
+  }
+
+  // Extremos da projeção no eixo
+  float minProj = 1e30f;
+  float maxProj = -1e30f;
+  int minIdx = 0;
+  int maxIdx = 0;
+  for (int i = 0; i < 16; ++i) {
+    float proj = block[i][0] * axis[0] + block[i][1] * axis[1] +
+                 block[i][2] * axis[2];
+    if (proj < minProj) {
+      minProj = proj;
+      minIdx = i;
+    }
+    if (proj > maxProj) {
+      maxProj = proj;
+      maxIdx = i;
+    }
+  }
+  float maxColor[3] = {float(block[maxIdx][0]), float(block[maxIdx][1]),
+                       float(block[maxIdx][2])};
+  float minColor[3] = {float(block[minIdx][0]), float(block[minIdx][1]),
+                       float(block[minIdx][2])};
+  uint16_t c0 = PackRgb565(maxColor);
+  uint16_t c1 = PackRgb565(minColor);
+  // Modo de 4 cores exige c0 > c1
+  if (c0 < c1) {
+    std::swap(c0, c1);
+  }
+
+  uint32_t indices = 0;
+  if (c0 != c1) {
+    // Paleta: c0, c1, 2/3 c0 + 1/3 c1, 1/3 c0 + 2/3 c1
+    int palette[4][3];
+    UnpackRgb565(c0, palette[0]);
+    UnpackRgb565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c) {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+    for (int i = 0; i < 16; ++i) {
+      int best = 0;
+      int bestDist = 1 << 30;
+      for (int p = 0; p < 4; ++p) {
+        int dr = block[i][0] - palette[p][0];
+        int dg = block[i][1] - palette[p][1];
+        int db = block[i][2] - palette[p][2];
+        int dist = dr * dr + dg * dg + db * db;
+        if (dist < bestDist) {
+          bestDist = dist;
+          best = p;
+        }
+      }
+      indices |= static_cast<uint32_t>(best) << (i * 2);
+    }
+  }
+
+  out[0] = static_cast<unsigned char>(c0 & 0xff);
+  out[1] = static_cast<unsigned char>(c0 >> 8);
+  out[2] = static_cast<unsigned char>(c1 & 0xff);
+  out[3] = static_cast<unsigned char>(c1 >> 8);
+  for (int b = 0; b < 4; ++b) {
+    out[4 + b] = static_cast<unsigned char>((indices >> (b * 8)) & 0xff);
+  }
+}
+
+// Bloco de alfa BC3/BC4 (8 bytes) no modo de 8 valores interpolados
+void EncodeAlphaBlock(const unsigned char block[16][4], unsigned char out[8]) {
+  int a0 = 0;
+  int a1 = 255;
+  for (int i = 0; i < 16; ++i) {
+    a0 = std::max(a0, static_cast<int>(block[i][3]));
+    a1 = std::min(a1, static_cast<int>(block[i][3]));
+  }
+
+  uint64_t indices = 0;
+  if (a0 != a1) {
+    // Paleta: a0, a1 e 6 valores entre eles
+    int palette[8] = {a0, a1};
+    for (int k = 1; k <= 6; ++k) {
+      palette[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+    }
+    for (int i = 0; i < 16; ++i) {
+      int best = 0;
+      int bestDist = 1 << 30;
+      for (int p = 0; p < 8; ++p) {
+        int dist = std::abs(block[i][3] - palette[p]);
+        if (dist < bestDist) {
+          bestDist = dist;
+          best = p;
+        }
+      }
+      indices |= static_cast<uint64_t>(best) << (i * 3);
+    }
+  }
+
+  out[0] = static_cast<unsigned char>(a0);
+  out[1] = static_cast<unsigned char>(a1);
+  for (int b = 0; b < 6; ++b) {
+    out[2 + b] = static_cast<unsigned char>((indices >> (b * 8)) & 0xff);
+  }
+}
+
+// Comprime um nível inteiro, bloco a bloco (bordas repetem o último pixel)
+void CompressLevel(const unsigned char *rgba, int width, int height,
+                   bool withAlpha, unsigned char *out) {
+  unsigned char block[16][4];
+  for (int by = 0; by < height; by += 4) {
+    for (int bx = 0; bx < width; bx += 4) {
+      for (int i = 0; i < 16; ++i) {
+        int x = std::min(bx + (i % 4), width - 1);
+        int y = std::min(by + (i / 4), height - 1);
+        std::memcpy(block[i], rgba + (static_cast<size_t>(y) * width + x) * 4,
+                    4);
+      }
+      if (withAlpha) {
+        EncodeAlphaBlock(block, out);
+        out += 8;
+      }
+      EncodeColorBlock(block, out);
+      out += 8;
+    }
+  }
+}
+
+// Nome do cache ao lado da imagem (Layer 1.png -> Layer 1.png.ptex, ou
+// Layer 1.png.1024.ptex para a variante ".1024")
+std::string CompressedCachePath(const std::string &imagePath,
+                                const std::string &variant) {
+  return imagePath + variant + ".ptex";
+}
+
+// Amostra bilinear de um canal (coordenadas em pixels, presas à borda)
+float SampleBilinear(const unsigned char *src, int width, int height,
+                     float x, float y, int channel) {
+  x = std::clamp(x, 0.0f, static_cast<float>(width - 1));
+  y = std::clamp(y, 0.0f, static_cast<float>(height - 1));
+  int x0 = static_cast<int>(x);
+  int y0 = static_cast<int>(y);
+  int x1 = std::min(x0 + 1, width - 1);
+  int y1 = std::min(y0 + 1, height - 1);
+  float fx = x - x0;
+  float fy = y - y0;
+  auto at = [&](int px, int py) {
+    return static_cast<float>(
+        src[(static_cast<size_t>(py) * width + px) * 4 + channel]);
+  };
+  float top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * fx;
+  float bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * fx;
+  return top + (bottom - top) * fy;
+}
+}
+
+void CompressTexture(const unsigned char *rgba, int width, int height,
+                     MipChain &out) {
+  // BC3 só quando algum pixel não é opaco
+  bool withAlpha = false;
+  size_t pixelCount = static_cast<size_t>(width) * height;
+  for (size_t i = 0; i < pixelCount && !withAlpha; ++i) {
+    withAlpha = rgba[i * 4 + 3] != 255;
+  }
+  out.format = withAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+                         : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+  size_t blockBytes = withAlpha ? 16 : 8;
+  out.levels.clear();
+  out.data.clear();
+
+  // Comprime o nível atual e desce até 1x1
+  std::vector<unsigned char> current;
+  const unsigned char *level = rgba;
+  int levelWidth = width;
+  int levelHeight = height;
+  while (true) {
+    MipLevel info;
+    info.width = levelWidth;
+    info.height = levelHeight;
+    info.offset = out.data.size();
+    info.size = static_cast<size_t>((levelWidth + 3) / 4) *
+                ((levelHeight + 3) / 4) * blockBytes;
+    out.data.resize(info.offset + info.size);
+    CompressLevel(level, levelWidth, levelHeight, withAlpha,
+                  out.data.data() + info.offset);
+    out.levels.push_back(info);
+    if (levelWidth == 1 && levelHeight == 1) {
+      break;
+    }
+    int nextWidth = 0;
+    int nextHeight = 0;
+    current = Downsample(level, levelWidth, levelHeight, nextWidth, nextHeight);
+    level = current.data();
+    levelWidth = nextWidth;
+    levelHeight = nextHeight;
+  }
+}
+
+void BuildMipChain(const unsigned char *rgba, int width, int height,
+                   MipChain &out) {
+  out.format = GL_RGBA8;
+  out.levels.clear();
+  out.data.clear();
+  std::vector<unsigned char> current;
+  const unsigned char *level = rgba;
+  int levelWidth = width;
+  int levelHeight = height;
+  while (true) {
+    MipLevel info;
+    info.width = levelWidth;
+    info.height = levelHeight;
+    info.offset = out.data.size();
+    info.size = static_cast<size_t>(levelWidth) * levelHeight * 4;
+    out.data.insert(out.data.end(), level, level + info.size);
+    out.levels.push_back(info);
+    if (levelWidth == 1 && levelHeight == 1) {
+      break;
+    }
+    int nextWidth = 0;
+    int nextHeight = 0;
+    current = Downsample(level, levelWidth, levelHeight, nextWidth, nextHeight);
+    level = current.data();
+    levelWidth = nextWidth;
+    levelHeight = nextHeight;
+  }
+}
+
+void ResizeImage(const unsigned char *rgba, int width, int height,
+                 int outWidth, int outHeight, std::vector<unsigned char> &out) {
+  // Reduções grandes: metades com filtro de caixa (sem aliasing)
+  std::vector<unsigned char> current;
+  const unsigned char *src = rgba;
+  while (width >= outWidth * 2 && height >= outHeight * 2) {
+    int halfWidth = 0;
+    int halfHeight = 0;
+    current = Downsample(src, width, height, halfWidth, halfHeight);
+    src = current.data();
+    width = halfWidth;
+    height = halfHeight;
+  }
+
+  // Resto (no máximo 2x por eixo, ou ampliação): bilinear nos centros
+  out.resize(static_cast<size_t>(outWidth) * outHeight * 4);
+  float scaleX = static_cast<float>(width) / outWidth;
+  float scaleY = static_cast<float>(height) / outHeight;
+  for (int y = 0; y < outHeight; ++y) {
+    float sy = (y + 0.5f) * scaleY - 0.5f;
+    for (int x = 0; x < outWidth; ++x) {
+      float sx = (x + 0.5f) * scaleX - 0.5f;
+      for (int c = 0; c < 4; ++c) {
+        out[(static_cast<size_t>(y) * outWidth + x) * 4 + c] =
+            static_cast<unsigned char>(
+                SampleBilinear(src, width, height, sx, sy, c) + 0.5f);
+      }
+    }
+  }
+}
+
+bool StackMipChains(const std::vector<MipChain> &layers, MipChain &out) {
+  if (layers.empty()) {
+    return false;
+  }
+  const MipChain &first = layers[0];
+  for (const auto &layer : layers) {
+    if (layer.format != first.format ||
+        layer.levels.size() != first.levels.size() || layer.layers != 1 ||
+        layer.levels[0].width != first.levels[0].width ||
+        layer.levels[0].height != first.levels[0].height) {
+      return false;
+    }
+  }
+
+  // Cada nível leva as camadas todas seguidas (como o glTexImage3D espera)
+  out.format = first.format;
+  out.layers = static_cast<int>(layers.size());
+  out.levels.clear();
+  out.data.clear();
+  for (size_t level = 0; level < first.levels.size(); ++level) {
+    MipLevel info = first.levels[level];
+    info.offset = out.data.size();
+    for (const auto &layer : layers) {
+      const MipLevel &source = layer.levels[level];
+      const unsigned char *bytes = layer.data.data() + source.offset;
+      out.data.insert(out.data.end(), bytes, bytes + source.size);
+    }
+    info.size = out.data.size() - info.offset;
+    out.levels.push_back(info);
+  }
+  return true;
+}
+
+bool LoadCompressedCache(const std::string &imagePath, MipChain &texture,
+                         const std::string &variant) {
+  std::string cachePath = CompressedCachePath(imagePath, variant);
+  MappedFile file;
+  if (!OpenAsset(cachePath, file)) {
+    return false;
+  }
+
+  // Cabeçalho, imagem de origem e lista de níveis
+  CacheReader reader{file.data, file.data + file.size,
+                     AssetInArchive(cachePath)};
+  char magic[4];
+  uint32_t version = 0;
+  uint32_t levelCount = 0;
+  uint64_t dataSize = 0;
+  MipChain loaded;
+  bool ok = reader.Bytes(magic, sizeof(magic)) &&
+            std::memcmp(magic, kMagic, sizeof(magic)) == 0 &&
+            reader.Value(version) && version == kVersion &&
+            ReadSourceUnchanged(reader) && reader.Value(loaded.format) &&
+            reader.Value(levelCount) && reader.Value(dataSize);
+  for (uint32_t i = 0; ok && i < levelCount; ++i) {
+    MipLevel level;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    ok = reader.Value(level.width) && reader.Value(level.height) &&
+         reader.Value(offset) && reader.Value(size) &&
+         offset + size <= dataSize;
+    level.offset = static_cast<size_t>(offset);
+    level.size = static_cast<size_t>(size);
+    loaded.levels.push_back(level);
+  }
+  ok = ok && dataSize <= static_cast<uint64_t>(reader.end - reader.cur);
+  if (ok) {
+    loaded.data.resize(static_cast<size_t>(dataSize));
+    ok = reader.Bytes(loaded.data.data(), loaded.data.size());
+  }
+  UnmapFile(file);
+  if (!ok || loaded.levels.empty()) {
+    return false;
+  }
+  texture = std::move(loaded);
+  return true;
+}
+
+bool SaveCompressedCache(const std::string &imagePath, const MipChain &texture,
+                         const std::string &variant) {
+  // Escreve para um temporário e renomeia no fim
+  std::string cachePath = CompressedCachePath(imagePath, variant);
+  std::string tmpPath = cachePath + ".tmp";
+  std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    std::cerr << "Nao foi possivel escrever cache: " << cachePath << "\n";
+    return false;
+  }
+
+  CacheWriter writer{out};
+  writer.Bytes(kMagic, sizeof(kMagic));
+  writer.Value(kVersion);
+  WriteSourceStamp(writer, imagePath);
+  writer.Value(texture.format);
+  writer.Value(static_cast<uint32_t>(texture.levels.size()));
+  writer.Value(static_cast<uint64_t>(texture.data.size()));
+  for (const auto &level : texture.levels) {
+    writer.Value(level.width);
+    writer.Value(level.height);
+    writer.Value(static_cast<uint64_t>(level.offset));
+    writer.Value(static_cast<uint64_t>(level.size));
+  }
+  writer.Bytes(texture.data.data(), texture.data.size());
+
+  out.close();
+  if (!out || std::rename(tmpPath.c_str(), cachePath.c_str()) != 0) {
+    std::remove(tmpPath.c_str());
+    std::cerr << "Nao foi possivel escrever cache: " << cachePath << "\n";
+    return false;
+  }
+  return true;
+}
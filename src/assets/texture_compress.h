@@ -0,0 +1,48 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct MipLevel {
+  // Dimensões e posição do nível de mip dentro de data (com todas as
+  // camadas, uma a seguir à outra)
+  int width = 0;
+  int height = 0;
+  size_t offset = 0;
+  size_t size = 0;
+};
+
+struct MipChain {
+  // GL_COMPRESSED_RGB_S3TC_DXT1_EXT (BC1), ..._DXT5_EXT (BC3) ou GL_RGBA8
+  // (sem compressão); 0 = vazio
+  GLenum format = 0;
+  // Camadas (GL_TEXTURE_2D_ARRAY); 1 para texturas 2D
+  int layers = 1;
+  // Cadeia de mips completa, do nível 0 até 1x1
+  std::vector<MipLevel> levels;
+  std::vector<unsigned char> data;
+};
+
+// Gera os mips (filtro de caixa) e comprime cada nível: BC1 para imagens
+// opacas, BC3 quando há alfa
+void CompressTexture(const unsigned char *rgba, int width, int height,
+                     MipChain &out);
+// Gera os mips RGBA8 (filtro de caixa) sem comprimir
+void BuildMipChain(const unsigned char *rgba, int width, int height,
+                   MipChain &out);
+// Reamostra uma imagem RGBA8 (metades com filtro de caixa e depois
+// bilinear até ao tamanho pedido)
+void ResizeImage(const unsigned char *rgba, int width, int height,
+                 int outWidth, int outHeight, std::vector<unsigned char> &out);
+// Junta cadeias com o mesmo formato e tamanho numa só com várias camadas
+bool StackMipChains(const std::vector<MipChain> &layers, MipChain &out);
+// Carrega a versão comprimida do cache (.ptex) se a imagem não mudou;
+// variant distingue versões derivadas da mesma imagem (ex.: reamostrada)
+bool LoadCompressedCache(const std::string &imagePath, MipChain &texture,
+                         const std::string &variant = "");
+// Guarda a versão comprimida ao lado da imagem original
+bool SaveCompressedCache(const std::string &imagePath, const MipChain &texture,
+                         const std::string &variant = "");
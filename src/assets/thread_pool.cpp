@@ -0,0 +1,118 @@
+#include "assets/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace {
+// Ciclo de cada thread: espera por tarefas até o pool parar
+void WorkerLoop(ThreadPool &pool) {
+  while (true) {
+    std::packaged_task<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(pool.mutex);
+      pool.wake.wait(lock,
+                     [&pool]() { return pool.stopping || !pool.jobs.empty(); });
+      if (pool.jobs.empty()) {
+        return;
+      }
+      job = std::move(pool.jobs.front());
+      pool.jobs.pop_front();
+    }
+    job();
+  }
+}
+
+// Estado de um ParallelFor; partilhado porque uma ajuda pode só arrancar
+// depois de a chamada ter terminado
+struct ParallelState {
+  const std::function<void(size_t)> *fn = nullptr;
+  size_t count = 0;
+  std::atomic<size_t> next{0};
+  size_t done = 0;
+  std::mutex mutex;
+  std::condition_variable finished;
+};
+
+// Tira itens até não sobrar nenhum
+void RunItems(ParallelState &state) {
+  while (true) {
+    size_t i = state.next.fetch_add(1);
+    if (i >= state.count) {
+      return;
+    }
+    (*state.fn)(i);
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (++state.done == state.count) {
+      state.finished.notify_all();
+    }
+  }
+}
+}
+
+ThreadPool::~ThreadPool() { StopThreadPool(*this); }
+
+void StartThreadPool(ThreadPool &pool, unsigned threadCount) {
+  // Por omissão deixa um núcleo livre para a thread de render
+  if (threadCount == 0) {
+    unsigned hw = std::thread::hardware_concurrency();
+    threadCount = std::max(1u, hw > 1 ? hw - 1 : 1u);
+  }
+  pool.stopping = false;
+  for (unsigned i = 0; i < threadCount; ++i) {
+    pool.workers.emplace_back([&pool]() { WorkerLoop(pool); });
+  }
+}
+
+std::future<void> SubmitJob(ThreadPool &pool, std::function<void()> job) {
+  std::packaged_task<void()> task(std::move(job));
+  std::future<void> done = task.get_future();
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.jobs.push_back(std::move(task));
+  }
+  pool.wake.notify_one();
+  return done;
+}
+
+void StopThreadPool(ThreadPool &pool) {
+  // As tarefas já na fila ainda são executadas antes de sair
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.stopping = true;
+  }
+  pool.wake.notify_all();
+  for (auto &worker : pool.workers) {
+    worker.join();
+  }
+  pool.workers.clear();
+}
+
+void ParallelFor(ThreadPool &pool, size_t count,
+                 const std::function<void(size_t)> &fn) {
+  if (count <= 1) {
+    if (count == 1) {
+      fn(0);
+    }
+    return;
+  }
+  auto state = std::make_shared<ParallelState>();
+  state->fn = &fn;
+  state->count = count;
+  size_t helpers = std::min(count - 1, pool.workers.size());
+  for (size_t i = 0; i < helpers; ++i) {
+    SubmitJob(pool, [state]() { RunItems(*state); });
+  }
+  RunItems(*state);
+  // Só falta esperar pelos itens que as ajudas já tiraram
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->finished.wait(lock,
+                       [&state]() { return state->done == state->count; });
+}
+
+ThreadPool &SharedThreadPool() {
+  static ThreadPool pool;
+  static std::once_flag started;
+  std::call_once(started, []() { StartThreadPool(pool); });
+  return pool;
+}
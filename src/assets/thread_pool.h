@@ -0,0 +1,35 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct ThreadPool {
+  // Threads de trabalho
+  std::vector<std::thread> workers;
+  // Fila de tarefas pendentes
+  std::deque<std::packaged_task<void()>> jobs;
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool stopping = false;
+
+  ~ThreadPool();
+};
+
+// Arranca as threads do pool (0 = núcleos disponíveis menos um)
+void StartThreadPool(ThreadPool &pool, unsigned threadCount = 0);
+// Coloca uma tarefa na fila; o future fica pronto quando ela terminar
+std::future<void> SubmitJob(ThreadPool &pool, std::function<void()> job);
+// Termina as tarefas pendentes e junta as threads
+void StopThreadPool(ThreadPool &pool);
+// Corre fn(i) para i em [0, count) no pool; a thread que chama também tira
+// itens e só espera pelos que já estão a correr, por isso pode ser usada
+// dentro de uma tarefa do próprio pool
+void ParallelFor(ThreadPool &pool, size_t count,
+                 const std::function<void(size_t)> &fn);
+// Pool partilhado pelo carregamento de assets (criado no primeiro uso)
+ThreadPool &SharedThreadPool();
@@ -1,6 +1,7 @@
 #include "road.h"
 
 #include <cmath>
+#include <iostream>
 #include <unordered_set>
 #include <vector>
 
@@ -41,12 +42,19 @@ void ExtractRoadPoints(const Model &model, float worldScale,
     if (kRoadMaterials.find(mesh.materialName) == kRoadMaterials.end()) {
       continue;
     }
+    if (mesh.vertices.empty() && mesh.geometry.indexCount > 0) {
+      // Extrair antes de ReleaseCpuGeometry
+      std::cerr << "Estrada sem vertices em CPU: " << mesh.materialName
+                << "\n";
+      continue;
+    }
     const auto &verts = mesh.vertices;
-    for (size_t i = 0; i + 2 < verts.size(); i += 3) {
+    const auto &indices = mesh.indices;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
       // Converte para 2D e guarda o triângulo
-      Vec3 p0 = verts[i].position * worldScale;
-      Vec3 p1 = verts[i + 1].position * worldScale;
-      Vec3 p2 = verts[i + 2].position * worldScale;
+      Vec3 p0 = verts[indices[i]].position * worldScale;
+      Vec3 p1 = verts[indices[i + 1]].position * worldScale;
+      Vec3 p2 = verts[indices[i + 2]].position * worldScale;
       Vec2 pts[3] = {{p0.x, p0.z}, {p1.x, p1.z}, {p2.x, p2.z}};
       outTriangles.push_back({pts[0], pts[1], pts[2]});
       for (const auto &pt : pts) {
@@ -2,8 +2,16 @@
 #include <GLFW/glfw3.h>
 
 #include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <vector>
+#include "assets/asset_archive.h"
+#include "assets/geometry_buffer.h"
+#include "assets/hot_reload.h"
+#include "assets/mesh_lod.h"
 #include "assets/model.h"
+#include "assets/residency.h"
+#include "assets/texture.h"
 #include "audio.h"
 #include "game/collision.h"
 #include "game/game_state.h"
@@ -12,6 +20,8 @@
 #include "gl_utils.h"
 #include "math.h"
 #include "menu/menu.h"
+#include "render/gpu_profiler.h"
+#include "render/render_queue.h"
 
 // função para fazer uma transição linear suave entre dois valores float- usada em altura, distancias e velocidades
 static float LerpFloat(float a, float b, float t) { return a + (b - a) * t; }
@@ -24,6 +34,30 @@ static Vec3 LerpVec3(const Vec3 &a, const Vec3 &b, float t) {
           LerpFloat(a.z, b.z, clamped)};
 }
 
+// Carros de trânsito parados em pontos espaçados da estrada, com cores
+// alternadas (um lote instanciado do modelo do carro)
+static std::vector<GpuInstance>
+PlaceTrafficCars(const std::vector<Vec2> &roadPoints, size_t count, float y,
+                 float scale) {
+  static const Vec3 kTints[] = {{1.0f, 1.0f, 1.0f}, {0.9f, 0.3f, 0.3f},
+                                {0.3f, 0.5f, 0.9f}, {0.4f, 0.8f, 0.4f},
+                                {0.9f, 0.8f, 0.3f}};
+  std::vector<GpuInstance> instances;
+  if (roadPoints.empty() || count == 0) {
+    return instances;
+  }
+  size_t step = std::max<size_t>(roadPoints.size() / count, 1);
+  for (size_t i = 0; i < count && i * step < roadPoints.size(); ++i) {
+    const Vec2 &point = roadPoints[i * step];
+    Mat4 transform = Mat4Multiply(
+        Mat4Translate({point.x, y, point.y}),
+        Mat4Multiply(Mat4RotateY(i * 2.4f), Mat4Scale(scale)));
+    const Vec3 &tint = kTints[i % (sizeof(kTints) / sizeof(kTints[0]))];
+    instances.push_back(MakeInstance(transform, tint));
+  }
+  return instances;
+}
+
 //função de suavização - usada para transições de câmera e efeitos visuais
 static float SmoothStep01(float t) {
   // Suavizacao [0,1]
@@ -65,6 +99,19 @@ int main() {
   glEnable(GL_DEPTH_TEST);
   glClearColor(0.18f, 0.19f, 0.21f, 1.0f); //define cor de fundo 
 
+  // Recarga a quente de shaders, modelos e texturas (ferramenta de
+  // desenvolvimento, para afinar sem reiniciar); os ficheiros são lidos
+  // soltos do disco
+  const bool hotReload = false;
+
+  // Arquivo de assets (make assets): se existir, todos os ficheiros vêm
+  // dele; senão são lidos soltos do disco. Fica montado até ao fim: os
+  // jobs de streaming e as reposições do orçamento de VRAM leem dele
+  // depois do arranque
+  if (!hotReload) {
+    MountAssetArchive("assets.pak");
+  }
+
   // Audio em loop
   const char *musicPath = "src/music/Mr Bean Music.mp3";
   if (!InitAudioEngine(musicPath)) {
@@ -103,44 +150,59 @@ int main() {
   }
 
   // Carrega modelos 3D
+  const char *trackPath = "assets/textures/pista/pista.obj";
+  const char *carPath = "assets/textures/carro/MrBeanCarFinal.obj";
+  const char *policeCarPath = "assets/textures/carro_policia/Ford Crown "
+                              "Victoria Police Interceptor.obj";
+  // Relatórios da reordenação e da memória só no arranque (as recargas a
+  // quente carregam em silêncio)
+  ObjLoadConfig loadConfig;
+  loadConfig.reportOptimization = true;
+  loadConfig.reportMemory = true;
   Model trackModel;
-  if (!LoadObj("assets/textures/pista/pista.obj", trackModel)) {
+  if (!LoadObj(trackPath, trackModel, loadConfig)) {
     glfwDestroyWindow(window);
     glfwTerminate();
     return 1;
   }
 
   Model carModel;
-  if (!LoadObj("assets/textures/carro/MrBeanCarFinal.obj", carModel)) {
+  if (!LoadObj(carPath, carModel, loadConfig)) {
     glfwDestroyWindow(window);
     glfwTerminate();
     return 1;
   }
 
   Model policeCarModel;
-  if (!LoadObj("assets/textures/carro_policia/Ford Crown Victoria Police "
-               "Interceptor.obj",
-               policeCarModel)) {
+  if (!LoadObj(policeCarPath, policeCarModel, loadConfig)) {
     glfwDestroyWindow(window);
     glfwTerminate();
     return 1;
   }
 
-  // Prepara texturas e buffers de cada modelo
-  SetupTextures(trackModel);
-  SetupTextures(carModel);
-  SetupTextures(policeCarModel);
-
-  for (auto &mesh : trackModel.meshes) {
-    SetupMesh(mesh);
-  }
-  for (auto &mesh : carModel.meshes) {
-    SetupMesh(mesh);
-  }
-  for (auto &mesh : policeCarModel.meshes) {
-    SetupMesh(mesh);
+  // Prepara arrays de texturas e materiais de cada modelo
+  SetupMaterials(trackModel);
+  SetupMaterials(carModel);
+  SetupMaterials(policeCarModel);
+
+  // Formato de vértice compacto (16 bytes) para poupar banda em iGPUs
+  const bool compactVertices = false;
+  // Geometria só na GPU: a CPU fica apenas com a colisão da estrada
+  const bool gpuResident = true;
+  ModelUploadConfig uploadConfig;
+  uploadConfig.compactVertices = compactVertices;
+  uploadConfig.gpuResident = gpuResident;
+  for (Model *model : {&trackModel, &carModel, &policeCarModel}) {
+    UploadModel(*model, uploadConfig);
   }
 
+  // Orçamento de VRAM (iGPUs partilham a RAM: passar dele dá soluços);
+  // acima dele os menus são largados durante o jogo e as texturas menos
+  // usadas reduzidas
+  const size_t vramBudget = 256 * 1024 * 1024;
+  SetVramBudget(vramBudget);
+  PrintVramUsage(std::cout);
+
   // HUD simples (barra de tempo)
   GLuint hudTexture = 0;
   glGenTextures(1, &hudTexture);
@@ -168,37 +230,23 @@ int main() {
 
   // Compila shaders
   GLuint trackProgram =
-      CreateProgram("shaders/track_vertex.vs", "shaders/track_fragment.fs");
+      CreateAssetProgram("shaders/track_vertex.vs", "shaders/track_fragment.fs");
   GLuint carProgram =
-      CreateProgram("shaders/car_vertex.vs", "shaders/car_fragment.fs");
-  if (!trackProgram || !carProgram) {
+      CreateAssetProgram("shaders/car_vertex.vs", "shaders/car_fragment.fs");
+  // Variante que lê matriz e cor por instância (trânsito)
+  GLuint carInstancedProgram =
+      CreateAssetProgram("shaders/car_instanced.vs", "shaders/car_fragment.fs");
+  if (!trackProgram || !carProgram || !carInstancedProgram) {
     glfwDestroyWindow(window);
     glfwTerminate();
     return 1;
   }
-
-  // Locacoes de uniforms
-  GLint trackLocModel = glGetUniformLocation(trackProgram, "uModel");
-  GLint trackLocView = glGetUniformLocation(trackProgram, "uView");
-  GLint trackLocProj = glGetUniformLocation(trackProgram, "uProj");
-  GLint trackLocColor = glGetUniformLocation(trackProgram, "uColor");
-  GLint trackLocLight = glGetUniformLocation(trackProgram, "uLightDir");
-  GLint trackLocLight2 = glGetUniformLocation(trackProgram, "uLightDir2");
-  GLint trackLocAmbient = glGetUniformLocation(trackProgram, "uAmbient");
-  GLint trackLocViewPos = glGetUniformLocation(trackProgram, "uViewPos");
-  GLint trackLocTexture = glGetUniformLocation(trackProgram, "uTexture");
-  GLint trackLocUseTexture = glGetUniformLocation(trackProgram, "uUseTexture");
-
-  GLint carLocModel = glGetUniformLocation(carProgram, "uModel");
-  GLint carLocView = glGetUniformLocation(carProgram, "uView");
-  GLint carLocProj = glGetUniformLocation(carProgram, "uProj");
-  GLint carLocColor = glGetUniformLocation(carProgram, "uColor");
-  GLint carLocLight = glGetUniformLocation(carProgram, "uLightDir");
-  GLint carLocLight2 = glGetUniformLocation(carProgram, "uLightDir2");
-  GLint carLocAmbient = glGetUniformLocation(carProgram, "uAmbient");
-  GLint carLocViewPos = glGetUniformLocation(carProgram, "uViewPos");
-  GLint carLocTexture = glGetUniformLocation(carProgram, "uTexture");
-  GLint carLocUseTexture = glGetUniformLocation(carProgram, "uUseTexture");
+  // Locacoes de uniforms (voltam a ser lidas se o shader for recarregado)
+  // (o nome é o scope do profiler de GPU que mede os draws de cada um)
+  MeshProgram trackLoc = QueryMeshProgram(trackProgram, "pista");
+  MeshProgram carLoc = QueryMeshProgram(carProgram, "carros");
+  MeshProgram carInstancedLoc =
+      QueryMeshProgram(carInstancedProgram, "carros");
 
   // Escalas do mundo e veiculos
   const float worldScale = 40.0f;
@@ -227,6 +275,57 @@ int main() {
   gameState.police.heading = 0.0f;
   ExtractRoadPoints(trackModel, worldScale, gameState.roadPoints,
                     gameState.roadTriangles);
+  // Itens de desenho de cada modelo (mesh, material e VAO já resolvidos)
+  RenderModel trackRender = CompileRenderModel(trackModel);
+  RenderModel carRender = CompileRenderModel(carModel);
+  RenderModel policeCarRender = CompileRenderModel(policeCarModel);
+  RenderQueue renderQueue;
+  InitRenderQueue(renderQueue);
+
+  // Carro da polícia: lote instanciado de um só carro (mesmo programa do
+  // trânsito, o caminho instanciado corre em todos os frames)
+  std::vector<GpuInstance> policeCars(1);
+  // Trânsito: cópias do carro num só draw instanciado por mesh (200 é o
+  // cenário de teste de carga; 0 desliga)
+  const size_t trafficCarCount = 0;
+  const float trafficY = -carModel.minY * carScale + carLift + 0.05f;
+  std::vector<GpuInstance> trafficCars = PlaceTrafficCars(
+      gameState.roadPoints, trafficCarCount, trafficY, carScale);
+  if (gpuResident) {
+    for (Model *model : {&trackModel, &carModel, &policeCarModel}) {
+      ReleaseCpuGeometry(*model);
+    }
+  }
+
+  HotReload reload;
+  if (hotReload && InitHotReload(reload)) {
+    WatchProgram(reload, "shaders/track_vertex.vs", "shaders/track_fragment.fs",
+                 trackProgram,
+                 [&]() { trackLoc = QueryMeshProgram(trackProgram, "pista"); });
+    WatchProgram(reload, "shaders/car_vertex.vs", "shaders/car_fragment.fs",
+                 carProgram,
+                 [&]() { carLoc = QueryMeshProgram(carProgram, "carros"); });
+    WatchProgram(reload, "shaders/car_instanced.vs", "shaders/car_fragment.fs",
+                 carInstancedProgram, [&]() {
+                   carInstancedLoc =
+                       QueryMeshProgram(carInstancedProgram, "carros");
+                 });
+    WatchModel(reload, trackPath, trackModel, uploadConfig, [&]() {
+      // A colisão depende da geometria da pista
+      gameState.roadPoints.clear();
+      gameState.roadTriangles.clear();
+      ExtractRoadPoints(trackModel, worldScale, gameState.roadPoints,
+                        gameState.roadTriangles);
+      trackRender = CompileRenderModel(trackModel);
+      trafficCars = PlaceTrafficCars(gameState.roadPoints, trafficCarCount,
+                                     trafficY, carScale);
+    });
+    WatchModel(reload, carPath, carModel, uploadConfig,
+               [&]() { carRender = CompileRenderModel(carModel); });
+    WatchModel(reload, policeCarPath, policeCarModel, uploadConfig, [&]() {
+      policeCarRender = CompileRenderModel(policeCarModel);
+    });
+  }
 
   bool gameOver = false;
   bool playerWon = false;
@@ -237,6 +336,40 @@ int main() {
   float startTime = 0.0f;
   float lastFrameTime = 0.0f;
 
+  // LOD atual de cada mesh, por instância (com histerese entre frames)
+  LodState trackLod;
+  LodState carLod;
+  LodState policeCarLod;
+  LodState trafficLod;
+  // Totais do culling (média por frame escrita no fim)
+  RenderStats cullTotals;
+  size_t renderedFrames = 0;
+
+  // Tempo de GPU por pass (pista, carros, HUD, menu): F3 liga e desliga
+  // durante o jogo. Ligado, escreve em gpu_profile.log a cada segundo; ao
+  // desligar (ou sair) escreve o resumo no terminal
+  const int gpuProfilerKey = GLFW_KEY_F3;
+  bool gpuProfiler = false;
+  bool gpuProfilerKeyDown = false;
+  std::ofstream gpuLog;
+  float lastGpuLogTime = 0.0f;
+  auto setGpuProfiler = [&](bool enabled) {
+    if (enabled == gpuProfiler) {
+      return;
+    }
+    gpuProfiler = enabled;
+    if (enabled) {
+      InitGpuProfiler();
+      if (!gpuLog.is_open()) {
+        gpuLog.open("gpu_profile.log");
+      }
+      return;
+    }
+    std::cout << "GPU por pass:\n";
+    PrintGpuProfile(std::cout);
+    CleanupGpuProfiler();
+  };
+
   auto resetGame = [&](float currentTime) {
     // Reinicia estado do jogo
     gameOver = false;
@@ -256,6 +389,22 @@ int main() {
   };
 
   auto renderFrame = [&](float currentTime) {
+    // Profiler de GPU: muda só quando a tecla passa a premida
+    bool profilerKey = glfwGetKey(window, gpuProfilerKey) == GLFW_PRESS;
+    if (profilerKey && !gpuProfilerKeyDown) {
+      setGpuProfiler(!gpuProfiler);
+    }
+    gpuProfilerKeyDown = profilerKey;
+    // Resultados de GPU de frames anteriores (sem esperar)
+    BeginGpuFrame();
+    // Aplica ficheiros alterados (o trabalho pesado corre no pool)
+    UpdateHotReload(reload);
+    // Envia mais mips das texturas em streaming e aplica o orçamento de VRAM
+    UpdateTextureStreaming();
+    UpdateVramBudget();
+    // HUD e menus do frame anterior ligaram outros VAOs
+    ResetGeometryBinding();
+
     // Atualiza tempo e HUD do titulo
     float deltaTime = currentTime - lastFrameTime;
     float elapsedTime = currentTime - startTime;
@@ -375,8 +524,10 @@ int main() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     float aspect = (height > 0) ? (static_cast<float>(width) / height) : 1.0f;
-    Mat4 proj =
-        Mat4Perspective(45.0f * 3.1415926f / 180.0f, aspect, 0.1f, 100.0f);
+    const float fovY = 45.0f * 3.1415926f / 180.0f;
+    Mat4 proj = Mat4Perspective(fovY, aspect, 0.1f, 100.0f);
+    // Pixels por unidade de mundo a distância 1 (para o erro dos LODs)
+    float pixelsPerUnit = height / (2.0f * std::tan(fovY * 0.5f));
 
     // Posicoes e camera
     Vec3 carPos = {gameState.player.position.x,
@@ -437,103 +588,49 @@ int main() {
         Mat4Multiply(Mat4RotateY(gameState.police.heading + carBaseRotation),
                      Mat4Scale(policeCarScale)));
 
-    // Desenha pista
-    glUseProgram(trackProgram);
-    glUniformMatrix4fv(trackLocModel, 1, GL_FALSE, trackMat.m);
-    glUniformMatrix4fv(trackLocView, 1, GL_FALSE, view.m);
-    glUniformMatrix4fv(trackLocProj, 1, GL_FALSE, proj.m);
-    glUniform3f(trackLocLight, -0.6f, -1.0f, -0.3f);
-    glUniform3f(trackLocLight2, 0.25f, -0.35f, 0.3f);
-    glUniform3f(trackLocAmbient, 0.22f, 0.22f, 0.22f);
-    glUniform3f(trackLocViewPos, eye.x, eye.y, eye.z);
-    glUniform1i(trackLocTexture, 0);
-
-    for (const auto &mesh : trackModel.meshes) {
-      const Material *material = nullptr;
-      auto it = trackModel.materials.find(mesh.materialName);
-      if (it != trackModel.materials.end()) {
-        material = &it->second;
-      }
-      Vec3 color = material ? material->kd : Vec3{0.6f, 0.6f, 0.6f};
-      glUniform3f(trackLocColor, color.x, color.y, color.z);
-      if (material && material->hasTexture) {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, material->textureId);
-        glUniform1i(trackLocUseTexture, 1);
-      } else {
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glUniform1i(trackLocUseTexture, 0);
-      }
-      glBindVertexArray(mesh.vao);
-      glDrawArrays(GL_TRIANGLES, 0,
-                   static_cast<GLsizei>(mesh.vertices.size()));
+    // Nível de detalhe de cada mesh pelo erro projetado no ecrã
+    SelectLods(trackModel, trackMat, eye, pixelsPerUnit, trackLod);
+    SelectLods(carModel, carMat, eye, pixelsPerUnit, carLod);
+    SelectLods(policeCarModel, policeCarMat, eye, pixelsPerUnit, policeCarLod);
+    // O lote inteiro usa o LOD da instância mais próxima
+    if (!trafficCars.empty()) {
+      SelectLods(carModel, NearestInstanceTransform(trafficCars, eye), eye,
+                 pixelsPerUnit, trafficLod);
     }
 
-    // Desenha carro do jogador
-    glUseProgram(carProgram);
-    glUniformMatrix4fv(carLocModel, 1, GL_FALSE, carMat.m);
-    glUniformMatrix4fv(carLocView, 1, GL_FALSE, view.m);
-    glUniformMatrix4fv(carLocProj, 1, GL_FALSE, proj.m);
-    glUniform3f(carLocLight, -0.6f, -1.0f, -0.3f);
-    glUniform3f(carLocLight2, 0.25f, -0.35f, 0.3f);
-    glUniform3f(carLocAmbient, 0.22f, 0.22f, 0.22f);
-    glUniform3f(carLocViewPos, eye.x, eye.y, eye.z);
-    glUniform1i(carLocTexture, 0);
-
-    for (const auto &mesh : carModel.meshes) {
-      const Material *material = nullptr;
-      auto it = carModel.materials.find(mesh.materialName);
-      if (it != carModel.materials.end()) {
-        material = &it->second;
-      }
-      Vec3 color = material ? material->kd : Vec3{0.6f, 0.6f, 0.6f};
-      glUniform3f(carLocColor, color.x, color.y, color.z);
-      if (material && material->hasTexture) {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, material->textureId);
-        glUniform1i(carLocUseTexture, 1);
-      } else {
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glUniform1i(carLocUseTexture, 0);
-      }
-      glBindVertexArray(mesh.vao);
-      glDrawArrays(GL_TRIANGLES, 0,
-                   static_cast<GLsizei>(mesh.vertices.size()));
-    }
-
-    // Desenha carro da policia
-    glUniformMatrix4fv(carLocModel, 1, GL_FALSE, policeCarMat.m);
-    glUniformMatrix4fv(carLocView, 1, GL_FALSE, view.m);
-    glUniformMatrix4fv(carLocProj, 1, GL_FALSE, proj.m);
-    glUniform3f(carLocLight, -0.6f, -1.0f, -0.3f);
-    glUniform3f(carLocAmbient, 0.22f, 0.22f, 0.22f);
-    glUniform3f(carLocViewPos, eye.x, eye.y, eye.z);
-    glUniform1i(carLocTexture, 0);
-
-    for (const auto &mesh : policeCarModel.meshes) {
-      const Material *material = nullptr;
-      auto it = policeCarModel.materials.find(mesh.materialName);
-      if (it != policeCarModel.materials.end()) {
-        material = &it->second;
-      }
-      Vec3 color = material ? material->kd : Vec3{0.6f, 0.6f, 0.6f};
-      glUniform3f(carLocColor, color.x, color.y, color.z);
-      if (material && material->hasTexture) {
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, material->textureId);
-        glUniform1i(carLocUseTexture, 1);
-      } else {
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glUniform1i(carLocUseTexture, 0);
-      }
-      glBindVertexArray(mesh.vao);
-      glDrawArrays(GL_TRIANGLES, 0,
-                   static_cast<GLsizei>(mesh.vertices.size()));
-    }
+    // Pista e carros numa fila ordenada por programa, texturas, VAO e
+    // profundidade
+    BeginRenderQueue(renderQueue);
+    SubmitRenderModel(renderQueue, trackRender, trackLoc, trackMat, trackLod,
+                      eye);
+    SubmitRenderModel(renderQueue, carRender, carLoc, carMat, carLod, eye);
+    policeCars[0] = MakeInstance(policeCarMat, {1.0f, 1.0f, 1.0f});
+    SubmitInstancedModel(renderQueue, policeCarRender, carInstancedLoc,
+                         policeCars, policeCarLod, eye);
+    SubmitInstancedModel(renderQueue, carRender, carInstancedLoc, trafficCars,
+                         trafficLod, eye);
+    FrameUniforms frameUniforms;
+    frameUniforms.view = view;
+    frameUniforms.proj = proj;
+    frameUniforms.lightDir = {-0.6f, -1.0f, -0.3f};
+    frameUniforms.lightDir2 = {0.25f, -0.35f, 0.3f};
+    frameUniforms.ambient = {0.22f, 0.22f, 0.22f};
+    frameUniforms.viewPos = eye;
+    // Os scopes "pista" e "carros" são abertos pela fila, por programa
+    ExecuteRenderQueue(renderQueue, frameUniforms);
+    cullTotals.visibleObjects += renderQueue.stats.visibleObjects;
+    cullTotals.culledObjects += renderQueue.stats.culledObjects;
+    cullTotals.culledDraws += renderQueue.stats.culledDraws;
+    cullTotals.draws += renderQueue.stats.draws;
+    cullTotals.culledInstances += renderQueue.stats.culledInstances;
+    cullTotals.instances += renderQueue.stats.instances;
+    ++renderedFrames;
 
     // Menus de fim de jogo
     if (gameOver && !playerWon) {
+      BeginGpuScope("menu");
       LoseMenuResult loseResult = ShowLoseMenu(menuUi, window, width, height);
+      EndGpuScope();
       if (loseResult.retry) {
         float now = static_cast<float>(glfwGetTime());
         resetGame(now);
@@ -541,7 +638,9 @@ int main() {
         glfwSetWindowShouldClose(window, GLFW_TRUE);
       }
     } else if (gameOver && playerWon) {
+      BeginGpuScope("menu");
       WinMenuResult winResult = ShowWinScreen(menuUi, window, width, height);
+      EndGpuScope();
       if (winResult.goToMenu) {
         // sinalizar retorno ao menu principal
         gameOver = false;
@@ -579,6 +678,7 @@ int main() {
           x0, y1, 0.0f, 0.0f, //
           x1, y1, 1.0f, 0.0f  //
       };
+      BeginGpuScope("hud");
       glDisable(GL_DEPTH_TEST);
       glUseProgram(menuUi.program);
       glActiveTexture(GL_TEXTURE0);
@@ -589,6 +689,17 @@ int main() {
       glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(verts), verts);
       glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
       glEnable(GL_DEPTH_TEST);
+      EndGpuScope();
+    }
+
+    // glfwSetTime(0) ao voltar do menu faz o tempo recuar
+    if (gpuProfiler && gpuLog &&
+        (currentTime - lastGpuLogTime >= 1.0f ||
+         currentTime < lastGpuLogTime)) {
+      lastGpuLogTime = currentTime;
+      gpuLog << "t=" << currentTime << "s\n";
+      PrintGpuProfile(gpuLog);
+      gpuLog.flush();
     }
 
     glfwSwapBuffers(window);
@@ -603,6 +714,9 @@ int main() {
       startTime = static_cast<float>(glfwGetTime());
       lastFrameTime = startTime;
     } else {
+      CleanupHotReload(reload);
+      StopTextureStreaming();
+      UnmountAssetArchive();
       CleanupMenuUi(menuUi);
       ShutdownAudioEngine();
       glfwDestroyWindow(window);
@@ -624,12 +738,32 @@ int main() {
     renderFrame(currentTime);
   }
 
+  if (renderedFrames > 0) {
+    double frames = static_cast<double>(renderedFrames);
+    std::cout << "Culling (media por frame): "
+              << cullTotals.visibleObjects / frames << " objetos desenhados, "
+              << cullTotals.culledObjects / frames << " cortados; "
+              << cullTotals.draws / frames << " draws, "
+              << cullTotals.culledDraws / frames << " meshes cortados; "
+              << cullTotals.instances / frames << " instancias, "
+              << cullTotals.culledInstances / frames << " cortadas\n";
+  }
+  // Resumo do profiler, se estiver ligado, e apaga as queries
+  setGpuProfiler(false);
+
   // Limpeza de recursos
+  CleanupHotReload(reload);
+  // Já não há descodificações em curso: o arquivo pode sair
+  StopTextureStreaming();
+  UnmountAssetArchive();
   glDeleteProgram(trackProgram);
   glDeleteProgram(carProgram);
+  glDeleteProgram(carInstancedProgram);
+  CleanupRenderQueue(renderQueue);
   CleanupModel(trackModel);
   CleanupModel(carModel);
   CleanupModel(policeCarModel);
+  CleanupGeometryBuffers();
   CleanupMenuUi(menuUi);
   if (hudTexture) {
     glDeleteTextures(1, &hudTexture);
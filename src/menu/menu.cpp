@@ -3,7 +3,10 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-#include "assets/model.h"
+#include "assets/asset_archive.h"
+#include "assets/residency.h"
+#include "assets/texture.h"
+#include "assets/texture_cache.h"
 #include "gl_utils.h"
 
 bool InitMenuUi(MenuUi &menu, const MenuBounds &bounds,
@@ -12,7 +15,7 @@ bool InitMenuUi(MenuUi &menu, const MenuBounds &bounds,
   // Guarda bounds (retangulos clicaveis) e cria shader do menu
   menu.bounds = bounds;
   menu.program =
-      CreateProgram("shaders/menu_vertex.vs", "shaders/menu_fragment.fs");
+      CreateAssetProgram("shaders/menu_vertex.vs", "shaders/menu_fragment.fs");
   if (!menu.program) {
     return false;
   }
@@ -41,10 +44,12 @@ bool InitMenuUi(MenuUi &menu, const MenuBounds &bounds,
                         (void *)(sizeof(float) * 2));
   glBindVertexArray(0);
 
-  // Carrega texturas dos menus
-  menu.startTexture = LoadTexture2D(startImage);
-  menu.loseTexture = LoadTexture2D(loseImage);
-  menu.winTexture = LoadTexture2D(winImage);
+  // Obtém as texturas dos menus do cache partilhado
+  std::vector<GLuint> textures =
+      AcquireTextures({startImage, loseImage, winImage});
+  menu.startTexture = textures[0];
+  menu.loseTexture = textures[1];
+  menu.winTexture = textures[2];
   return menu.startTexture != 0;
 }
 
@@ -66,6 +71,8 @@ bool RunStartMenu(MenuUi &menu, GLFWwindow *window) {
 
     // Desenha menu
     glUseProgram(menu.program);
+    // Pode ter sido largada pelo orçamento de VRAM durante o jogo
+    TouchGpuTexture(menu.startTexture);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, menu.startTexture);
     glUniform1i(menu.locTexture, 0);
@@ -75,6 +82,9 @@ bool RunStartMenu(MenuUi &menu, GLFWwindow *window) {
     // Evento e input do rato
     glfwSwapBuffers(window);
     glfwPollEvents();
+    // Aproveita o menu para ir enviando as texturas dos modelos
+    UpdateTextureStreaming();
+    UpdateVramBudget();
 
     // Trata clique na area do botao jogar
     double mouseX = 0.0;
@@ -117,6 +127,7 @@ LoseMenuResult ShowLoseMenu(MenuUi &menu, GLFWwindow *window, int width,
   glDisable(GL_DEPTH_TEST);
   glViewport(0, 0, width, height);
   glUseProgram(menu.program);
+  TouchGpuTexture(menu.loseTexture);
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, menu.loseTexture);
   glUniform1i(menu.locTexture, 0);
@@ -160,6 +171,7 @@ WinMenuResult ShowWinScreen(MenuUi &menu, GLFWwindow *window, int width,
   glDisable(GL_DEPTH_TEST);
   glViewport(0, 0, width, height);
   glUseProgram(menu.program);
+  TouchGpuTexture(menu.winTexture);
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, menu.winTexture);
   glUniform1i(menu.locTexture, 0);
@@ -194,15 +206,15 @@ WinMenuResult ShowWinScreen(MenuUi &menu, GLFWwindow *window, int width,
 void CleanupMenuUi(MenuUi &menu) {
   // Liberta recursos OpenGL do menu
   if (menu.startTexture) {
-    glDeleteTextures(1, &menu.startTexture);
+    ReleaseTexture(menu.startTexture);
     menu.startTexture = 0;
   }
   if (menu.loseTexture) {
-    glDeleteTextures(1, &menu.loseTexture);
+    ReleaseTexture(menu.loseTexture);
     menu.loseTexture = 0;
   }
   if (menu.winTexture) {
-    glDeleteTextures(1, &menu.winTexture);
+    ReleaseTexture(menu.winTexture);
     menu.winTexture = 0;
   }
   if (menu.vbo) {
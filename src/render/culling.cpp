@@ -0,0 +1,63 @@
+#include "render/culling.h"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+void ClearSpheres(SphereBatch &batch) {
+  batch.x.clear();
+  batch.y.clear();
+  batch.z.clear();
+  batch.radius.clear();
+}
+
+void PushSphere(SphereBatch &batch, const Vec3 &center, float radius) {
+  batch.x.push_back(center.x);
+  batch.y.push_back(center.y);
+  batch.z.push_back(center.z);
+  batch.radius.push_back(radius);
+}
+
+size_t CullSpheres(const Frustum &frustum, const SphereBatch &batch,
+                   std::vector<uint8_t> &visible) {
+  size_t count = batch.x.size();
+  visible.assign(count, 0);
+  size_t visibleCount = 0;
+  size_t i = 0;
+#ifdef __SSE__
+  // 4 esferas por iteração: distância a cada plano em paralelo; fora se
+  // ficar atrás de algum plano por mais do que o raio
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_loadu_ps(batch.x.data() + i);
+    __m128 y = _mm_loadu_ps(batch.y.data() + i);
+    __m128 z = _mm_loadu_ps(batch.z.data() + i);
+    __m128 negRadius =
+        _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(batch.radius.data() + i));
+    __m128 outside = _mm_setzero_ps();
+    for (const Plane &plane : frustum.planes) {
+      __m128 distance = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.normal.x)),
+                     _mm_mul_ps(y, _mm_set1_ps(plane.normal.y))),
+          _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.normal.z)),
+                     _mm_set1_ps(plane.d)));
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+    }
+    int mask = _mm_movemask_ps(outside);
+    for (int lane = 0; lane < 4; ++lane) {
+      if (!(mask & (1 << lane))) {
+        visible[i + lane] = 1;
+        ++visibleCount;
+      }
+    }
+  }
+#endif
+  // Resto (ou tudo sem SSE)
+  for (; i < count; ++i) {
+    Vec3 center = {batch.x[i], batch.y[i], batch.z[i]};
+    if (SphereInFrustum(frustum, center, batch.radius[i])) {
+      visible[i] = 1;
+      ++visibleCount;
+    }
+  }
+  return visibleCount;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "math.h"
+
+// Esferas em colunas separadas (x, y, z, raio) para o teste em lote
+struct SphereBatch {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  std::vector<float> radius;
+};
+
+void ClearSpheres(SphereBatch &batch);
+void PushSphere(SphereBatch &batch, const Vec3 &center, float radius);
+// Testa todas as esferas contra o frustum (4 de cada vez com SSE); visible[i]
+// fica 1 se a esfera i toca o frustum. Devolve quantas são visíveis
+size_t CullSpheres(const Frustum &frustum, const SphereBatch &batch,
+                   std::vector<uint8_t> &visible);
@@ -0,0 +1,168 @@
+#include "render/gpu_profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+// Frames em voo: os resultados de um frame só são lidos quando o slot dele
+// volta a ser usado, já sem o driver ter de esperar pela GPU
+const size_t kFrameLatency = 4;
+// Amostras guardadas por scope para mínimo, média e máximo
+const size_t kHistorySize = 120;
+
+struct Scope {
+  std::string name;
+  // Anel das últimas amostras (ms)
+  std::vector<double> history;
+  size_t next = 0;
+  double lastMs = 0.0;
+};
+
+struct PendingQuery {
+  GLuint query = 0;
+  size_t scope = 0;
+};
+
+struct FrameSlot {
+  // Queries livres deste slot e as que foram emitidas no frame dele
+  std::vector<GLuint> pool;
+  std::vector<PendingQuery> pending;
+};
+
+// Estado do profiler; só usado na thread de GL
+bool gEnabled = false;
+FrameSlot gFrames[kFrameLatency];
+size_t gFrame = 0;
+std::vector<Scope> gScopes;
+bool gInScope = false;
+
+size_t ScopeIndex(const char *name) {
+  for (size_t i = 0; i < gScopes.size(); ++i) {
+    if (gScopes[i].name == name) {
+      return i;
+    }
+  }
+  Scope scope;
+  scope.name = name;
+  gScopes.push_back(scope);
+  return gScopes.size() - 1;
+}
+
+void AddSample(Scope &scope, double ms) {
+  scope.lastMs = ms;
+  if (scope.history.size() < kHistorySize) {
+    scope.history.push_back(ms);
+  } else {
+    scope.history[scope.next] = ms;
+  }
+  scope.next = (scope.next + 1) % kHistorySize;
+}
+}
+
+void InitGpuProfiler() {
+  gEnabled = GLEW_ARB_timer_query != 0;
+  gFrame = 0;
+  gInScope = false;
+}
+
+void BeginGpuFrame() {
+  if (!gEnabled) {
+    return;
+  }
+  if (gInScope) {
+    EndGpuScope();
+  }
+  gFrame = (gFrame + 1) % kFrameLatency;
+  FrameSlot &slot = gFrames[gFrame];
+  for (const PendingQuery &pending : slot.pending) {
+    // Ainda não pronto ao fim de kFrameLatency frames: perde-se a amostra
+    // em vez de bloquear
+    GLint available = 0;
+    glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+      GLuint64 nanoseconds = 0;
+      glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &nanoseconds);
+      AddSample(gScopes[pending.scope], nanoseconds / 1.0e6);
+    }
+    slot.pool.push_back(pending.query);
+  }
+  slot.pending.clear();
+}
+
+void BeginGpuScope(const char *name) {
+  if (!gEnabled || gInScope) {
+    return;
+  }
+  FrameSlot &slot = gFrames[gFrame];
+  GLuint query = 0;
+  if (slot.pool.empty()) {
+    glGenQueries(1, &query);
+  } else {
+    query = slot.pool.back();
+    slot.pool.pop_back();
+  }
+  glBeginQuery(GL_TIME_ELAPSED, query);
+  slot.pending.push_back({query, ScopeIndex(name)});
+  gInScope = true;
+}
+
+void EndGpuScope() {
+  if (!gInScope) {
+    return;
+  }
+  glEndQuery(GL_TIME_ELAPSED);
+  gInScope = false;
+}
+
+std::vector<GpuScopeStats> GetGpuProfile() {
+  std::vector<GpuScopeStats> profile;
+  profile.reserve(gScopes.size());
+  for (const Scope &scope : gScopes) {
+    GpuScopeStats stats;
+    stats.name = scope.name;
+    stats.lastMs = scope.lastMs;
+    stats.samples = scope.history.size();
+    if (!scope.history.empty()) {
+      auto range =
+          std::minmax_element(scope.history.begin(), scope.history.end());
+      stats.minMs = *range.first;
+      stats.maxMs = *range.second;
+      double total = 0.0;
+      for (double ms : scope.history) {
+        total += ms;
+      }
+      stats.avgMs = total / scope.history.size();
+    }
+    profile.push_back(stats);
+  }
+  return profile;
+}
+
+void PrintGpuProfile(std::ostream &out) {
+  out << std::fixed << std::setprecision(3);
+  for (const GpuScopeStats &stats : GetGpuProfile()) {
+    out << "  " << stats.name << ": " << stats.avgMs << " ms (min "
+        << stats.minMs << ", max " << stats.maxMs << ", " << stats.samples
+        << " amostras)\n";
+  }
+  out << std::defaultfloat;
+}
+
+void CleanupGpuProfiler() {
+  if (gInScope) {
+    EndGpuScope();
+  }
+  for (FrameSlot &slot : gFrames) {
+    for (const PendingQuery &pending : slot.pending) {
+      slot.pool.push_back(pending.query);
+    }
+    if (!slot.pool.empty()) {
+      glDeleteQueries(static_cast<GLsizei>(slot.pool.size()),
+                      slot.pool.data());
+    }
+    slot.pool.clear();
+    slot.pending.clear();
+  }
+  gScopes.clear();
+  gEnabled = false;
+}
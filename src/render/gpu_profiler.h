@@ -0,0 +1,35 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct GpuScopeStats {
+  std::string name;
+  // Tempo de GPU em ms: última amostra e janela das mais recentes
+  double lastMs = 0.0;
+  double minMs = 0.0;
+  double avgMs = 0.0;
+  double maxMs = 0.0;
+  size_t samples = 0;
+};
+
+// Liga o profiler se houver GL_TIME_ELAPSED (sem ele as funções não fazem
+// nada); thread de GL
+void InitGpuProfiler();
+// Início do frame: lê, sem esperar, os resultados do frame mais antigo do
+// anel e reutiliza as queries dele
+void BeginGpuFrame();
+// Mede os comandos GL entre Begin e End; os scopes não podem ser aninhados
+// (um só GL_TIME_ELAPSED ativo de cada vez)
+void BeginGpuScope(const char *name);
+void EndGpuScope();
+// Estatísticas por scope, pela ordem em que apareceram
+std::vector<GpuScopeStats> GetGpuProfile();
+// Escreve uma linha por scope (ms: média, mínimo e máximo)
+void PrintGpuProfile(std::ostream &out);
+// Apaga as queries
+void CleanupGpuProfiler();
@@ -0,0 +1,425 @@
+#include "render/render_queue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "assets/residency.h"
+#include "render/gpu_profiler.h"
+
+namespace {
+// Bits de cada campo da chave (do mais significativo para o menos)
+const int kProgramBits = 8;
+const int kMaterialBits = 12;
+const int kVaoBits = 12;
+
+// Posição do valor na lista do frame (acrescenta se for novo), limitada aos
+// bits do campo
+template <typename T>
+uint64_t SlotOf(std::vector<T> &slots, const T &value, int bits) {
+  auto it = std::find(slots.begin(), slots.end(), value);
+  size_t slot = it - slots.begin();
+  if (it == slots.end()) {
+    slots.push_back(value);
+  }
+  return std::min<uint64_t>(slot, (uint64_t(1) << bits) - 1);
+}
+
+// Scopes do profiler com o mesmo nome (ou ambos sem medição)
+bool SameScope(const char *a, const char *b) {
+  return a == b || (a && b && std::strcmp(a, b) == 0);
+}
+
+// Distância positiva como inteiro: a ordem dos bits de um float positivo é
+// a ordem dos valores
+uint32_t DepthBits(float distance) {
+  distance = std::max(distance, 0.0f);
+  uint32_t bits = 0;
+  std::memcpy(&bits, &distance, sizeof(bits));
+  return bits;
+}
+
+Vec3 TransformPoint(const Mat4 &matrix, const Vec3 &p) {
+  const float *m = matrix.m;
+  return {m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12],
+          m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13],
+          m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]};
+}
+
+// Bloco Frame em std140 (cada vec3 ocupa 16 bytes)
+struct GpuFrame {
+  float view[16];
+  float proj[16];
+  float lightDir[4];
+  float lightDir2[4];
+  float ambient[4];
+  float viewPos[4];
+};
+
+// Bloco Object em std140: matriz, offset e escala do formato compacto e o
+// int uOctNormals no fim do vec3 da escala
+struct GpuObject {
+  float model[16];
+  float posOffset[4];
+  float posScale[3];
+  int32_t octNormals;
+};
+
+void CopyVec3(const Vec3 &v, float *out) {
+  out[0] = v.x;
+  out[1] = v.y;
+  out[2] = v.z;
+}
+
+// Matriz e descodificação do formato de vértice do objeto
+GpuObject MakeGpuObject(const QueuedObject &object) {
+  GpuObject data = {};
+  std::memcpy(data.model, object.transform.m, sizeof(data.model));
+  const Model &model = *object.model->model;
+  bool compact = !object.model->items.empty() &&
+                 object.model->items[0].mesh->geometry.compact;
+  if (compact) {
+    CopyVec3(model.boundsMin, data.posOffset);
+    CopyVec3(model.boundsMax - model.boundsMin, data.posScale);
+  } else {
+    CopyVec3({1.0f, 1.0f, 1.0f}, data.posScale);
+  }
+  data.octNormals = compact ? 1 : 0;
+  return data;
+}
+
+// Tira da fila o que está fora do frustum: instâncias (compactando os
+// intervalos dos lotes) e depois os draws, de uma vez cada
+void CullQueue(RenderQueue &queue, const Frustum &frustum, RenderStats &stats) {
+  if (!queue.instances.empty()) {
+    CullSpheres(frustum, queue.instanceSpheres, queue.visible);
+    size_t kept = 0;
+    for (QueuedObject &object : queue.objects) {
+      if (!object.instanced) {
+        continue;
+      }
+      size_t first = kept;
+      for (uint32_t i = 0; i < object.instanceCount; ++i) {
+        size_t index = object.firstInstance + i;
+        if (queue.visible[index]) {
+          queue.instances[kept++] = queue.instances[index];
+        } else {
+          ++stats.culledInstances;
+        }
+      }
+      object.firstInstance = static_cast<uint32_t>(first);
+      object.instanceCount = static_cast<uint32_t>(kept - first);
+    }
+    queue.instances.resize(kept);
+  }
+
+  // Os draws dos lotes têm esfera infinita: ficam se sobrar alguma instância
+  CullSpheres(frustum, queue.drawSpheres, queue.visible);
+  std::vector<uint8_t> objectVisible(queue.objects.size(), 0);
+  size_t kept = 0;
+  for (size_t i = 0; i < queue.draws.size(); ++i) {
+    const QueuedObject &object = queue.objects[queue.draws[i].object];
+    if (queue.visible[i] && (!object.instanced || object.instanceCount > 0)) {
+      objectVisible[queue.draws[i].object] = 1;
+      queue.draws[kept++] = queue.draws[i];
+    } else {
+      ++stats.culledDraws;
+    }
+  }
+  queue.draws.resize(kept);
+  for (uint8_t visible : objectVisible) {
+    if (visible) {
+      ++stats.visibleObjects;
+    } else {
+      ++stats.culledObjects;
+    }
+  }
+}
+
+void BindBlock(GLuint program, const char *name, GLuint binding) {
+  GLuint block = glGetUniformBlockIndex(program, name);
+  if (block != GL_INVALID_INDEX) {
+    glUniformBlockBinding(program, block, binding);
+  }
+}
+}
+
+MeshProgram QueryMeshProgram(GLuint program, const char *gpuScope) {
+  MeshProgram loc;
+  loc.program = program;
+  loc.gpuScope = gpuScope;
+  loc.material = glGetUniformLocation(program, "uMaterial");
+  BindBlock(program, "Frame", kFrameBinding);
+  BindBlock(program, "Object", kObjectBinding);
+  SetupMaterialProgram(program);
+  return loc;
+}
+
+void InitRenderQueue(RenderQueue &queue) {
+  glGenBuffers(1, &queue.frameBuffer);
+  glBindBuffer(GL_UNIFORM_BUFFER, queue.frameBuffer);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(GpuFrame), nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  TrackGpuBuffer(queue.frameBuffer, sizeof(GpuFrame), "frame");
+  glGenBuffers(1, &queue.objectBuffer);
+
+  // Cada objeto começa num múltiplo do alinhamento (glBindBufferRange)
+  GLint alignment = 256;
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+  size_t align = static_cast<size_t>(std::max(alignment, 1));
+  queue.objectStride = (sizeof(GpuObject) + align - 1) / align * align;
+  queue.objectCapacity = 0;
+}
+
+void CleanupRenderQueue(RenderQueue &queue) {
+  for (GLuint *buffer : {&queue.frameBuffer, &queue.objectBuffer}) {
+    if (*buffer) {
+      UntrackGpuBuffer(*buffer);
+      glDeleteBuffers(1, buffer);
+      *buffer = 0;
+    }
+  }
+  queue.objectCapacity = 0;
+}
+
+RenderModel CompileRenderModel(const Model &model) {
+  RenderModel compiled;
+  compiled.model = &model;
+  compiled.items.reserve(model.meshes.size());
+  for (size_t i = 0; i < model.meshes.size(); ++i) {
+    const Mesh &mesh = model.meshes[i];
+    if (mesh.geometry.indexCount == 0) {
+      continue;
+    }
+    DrawItem item;
+    item.mesh = &mesh;
+    item.meshIndex = static_cast<uint32_t>(i);
+    item.materialIndex = mesh.materialIndex;
+    item.vao = mesh.geometry.vao;
+    compiled.items.push_back(item);
+  }
+  compiled.boundsCenter = (model.boundsMin + model.boundsMax) * 0.5f;
+  compiled.boundsRadius = Length(model.boundsMax - model.boundsMin) * 0.5f;
+  return compiled;
+}
+
+void BeginRenderQueue(RenderQueue &queue) {
+  queue.objects.clear();
+  queue.draws.clear();
+  queue.instances.clear();
+  ClearSpheres(queue.drawSpheres);
+  ClearSpheres(queue.instanceSpheres);
+  queue.programs.clear();
+  queue.materialSets.clear();
+  queue.vaos.clear();
+}
+
+void SubmitRenderModel(RenderQueue &queue, const RenderModel &model,
+                       const MeshProgram &program, const Mat4 &transform,
+                       const LodState &lod, const Vec3 &eye) {
+  uint32_t object = static_cast<uint32_t>(queue.objects.size());
+  QueuedObject queued;
+  queued.model = &model;
+  queued.program = &program;
+  queued.transform = transform;
+  queued.lod = &lod;
+  queue.objects.push_back(queued);
+  float scale = Mat4MaxScale(transform);
+
+  // Programa e texturas são do objeto inteiro; VAO e profundidade por item
+  uint64_t prefix =
+      SlotOf(queue.programs, program.program, kProgramBits)
+          << (kMaterialBits + kVaoBits + 32) |
+      SlotOf(queue.materialSets, model.model, kMaterialBits)
+          << (kVaoBits + 32);
+  for (size_t i = 0; i < model.items.size(); ++i) {
+    const DrawItem &item = model.items[i];
+    Vec3 center = TransformPoint(transform, item.mesh->boundsCenter);
+    QueuedDraw draw;
+    draw.key = prefix | SlotOf(queue.vaos, item.vao, kVaoBits) << 32 |
+               DepthBits(Length(center - eye));
+    draw.object = object;
+    draw.item = static_cast<uint32_t>(i);
+    queue.draws.push_back(draw);
+    PushSphere(queue.drawSpheres, center, item.mesh->boundsRadius * scale);
+  }
+}
+
+void SubmitInstancedModel(RenderQueue &queue, const RenderModel &model,
+                          const MeshProgram &program,
+                          const std::vector<GpuInstance> &instances,
+                          const LodState &lod, const Vec3 &eye) {
+  if (instances.empty()) {
+    return;
+  }
+  // A matriz do bloco Object fica a identidade; cada instância traz a sua
+  SubmitRenderModel(queue, model, program, Mat4Identity(), lod, eye);
+  QueuedObject &object = queue.objects.back();
+  object.instanced = true;
+  object.firstInstance = static_cast<uint32_t>(queue.instances.size());
+  object.instanceCount = static_cast<uint32_t>(instances.size());
+  queue.instances.insert(queue.instances.end(), instances.begin(),
+                         instances.end());
+  for (const GpuInstance &instance : instances) {
+    Mat4 transform;
+    std::memcpy(transform.m, instance.model, sizeof(transform.m));
+    PushSphere(queue.instanceSpheres,
+               TransformPoint(transform, model.boundsCenter),
+               model.boundsRadius * Mat4MaxScale(transform));
+  }
+
+  // Profundidade pela instância mais próxima (os itens do lote são os
+  // últimos da fila)
+  Mat4 nearest = NearestInstanceTransform(instances, eye);
+  for (size_t i = queue.draws.size() - model.items.size();
+       i < queue.draws.size(); ++i) {
+    QueuedDraw &draw = queue.draws[i];
+    const DrawItem &item = model.items[draw.item];
+    Vec3 center = TransformPoint(nearest, item.mesh->boundsCenter);
+    draw.key = (draw.key & ~uint64_t(0xffffffff)) |
+               DepthBits(Length(center - eye));
+    // Cada instância é testada à parte
+    queue.drawSpheres.radius[i] = std::numeric_limits<float>::infinity();
+  }
+}
+
+GpuInstance MakeInstance(const Mat4 &transform, const Vec3 &tint) {
+  GpuInstance instance = {};
+  std::memcpy(instance.model, transform.m, sizeof(instance.model));
+  CopyVec3(tint, instance.tint);
+  instance.tint[3] = 1.0f;
+  return instance;
+}
+
+Mat4 NearestInstanceTransform(const std::vector<GpuInstance> &instances,
+                              const Vec3 &eye) {
+  Mat4 nearest = Mat4Identity();
+  float best = -1.0f;
+  for (const GpuInstance &instance : instances) {
+    Vec3 position = {instance.model[12], instance.model[13],
+                     instance.model[14]};
+    float distance = Length(position - eye);
+    if (best < 0.0f || distance < best) {
+      best = distance;
+      std::memcpy(nearest.m, instance.model, sizeof(nearest.m));
+    }
+  }
+  return nearest;
+}
+
+void ExecuteRenderQueue(RenderQueue &queue, const FrameUniforms &frame) {
+  // Culling antes de qualquer upload: o que fica fora não custa nada
+  RenderStats stats;
+  CullQueue(queue, ExtractFrustum(Mat4Multiply(frame.proj, frame.view)),
+            stats);
+
+  // Câmara e luzes: um upload por frame, ligado uma vez para todos os
+  // programas
+  GpuFrame frameData = {};
+  std::memcpy(frameData.view, frame.view.m, sizeof(frameData.view));
+  std::memcpy(frameData.proj, frame.proj.m, sizeof(frameData.proj));
+  CopyVec3(frame.lightDir, frameData.lightDir);
+  CopyVec3(frame.lightDir2, frameData.lightDir2);
+  CopyVec3(frame.ambient, frameData.ambient);
+  CopyVec3(frame.viewPos, frameData.viewPos);
+  glBindBuffer(GL_UNIFORM_BUFFER, queue.frameBuffer);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(frameData), &frameData);
+  glBindBufferBase(GL_UNIFORM_BUFFER, kFrameBinding, queue.frameBuffer);
+
+  // Objetos: todos num só upload (buffer órfão, o driver não espera pelo
+  // frame anterior); cada um é depois um intervalo do mesmo UBO
+  size_t objectBytes = queue.objects.size() * queue.objectStride;
+  if (queue.draws.empty()) {
+    queue.stats = stats;
+    return;
+  }
+  queue.objectData.assign(objectBytes, 0);
+  for (size_t i = 0; i < queue.objects.size(); ++i) {
+    GpuObject data = MakeGpuObject(queue.objects[i]);
+    std::memcpy(queue.objectData.data() + i * queue.objectStride, &data,
+                sizeof(data));
+  }
+  glBindBuffer(GL_UNIFORM_BUFFER, queue.objectBuffer);
+  if (objectBytes > queue.objectCapacity) {
+    queue.objectCapacity = std::max(objectBytes, queue.objectCapacity * 2);
+    TrackGpuBuffer(queue.objectBuffer, queue.objectCapacity, "objetos");
+  }
+  glBufferData(GL_UNIFORM_BUFFER, queue.objectCapacity, nullptr,
+               GL_STREAM_DRAW);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, objectBytes, queue.objectData.data());
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  // Instâncias de todos os lotes, também num só upload
+  UploadInstances(queue.instances);
+
+  std::sort(queue.draws.begin(), queue.draws.end(),
+            [](const QueuedDraw &a, const QueuedDraw &b) {
+              return a.key < b.key;
+            });
+
+  GLuint currentProgram = 0;
+  const char *currentScope = nullptr;
+  const Model *currentMaterials = nullptr;
+  GLuint currentVao = 0;
+  uint32_t currentObject = UINT32_MAX;
+  int currentMaterial = -1;
+  for (const QueuedDraw &draw : queue.draws) {
+    const QueuedObject &object = queue.objects[draw.object];
+    const MeshProgram &program = *object.program;
+    const DrawItem &item = object.model->items[draw.item];
+    const Model &model = *object.model->model;
+
+    // uMaterial é do programa: ao trocar volta a ser enviado
+    if (program.program != currentProgram) {
+      // A chave ordena primeiro pelo programa: cada um é um intervalo
+      // contínuo dos draws
+      if (!SameScope(program.gpuScope, currentScope)) {
+        if (currentScope) {
+          EndGpuScope();
+        }
+        if (program.gpuScope) {
+          BeginGpuScope(program.gpuScope);
+        }
+        currentScope = program.gpuScope;
+      }
+      glUseProgram(program.program);
+      currentProgram = program.program;
+      currentMaterial = -1;
+      ++stats.programBinds;
+    }
+    // Arrays e UBO de materiais são estado global
+    if (&model != currentMaterials) {
+      BindModelMaterials(model);
+      currentMaterials = &model;
+      ++stats.materialBinds;
+    }
+    // Os blocos Object são partilhados pelos programas: só muda o intervalo
+    if (draw.object != currentObject) {
+      glBindBufferRange(GL_UNIFORM_BUFFER, kObjectBinding, queue.objectBuffer,
+                        draw.object * queue.objectStride, sizeof(GpuObject));
+      currentObject = draw.object;
+      ++stats.objectBinds;
+    }
+    if (item.materialIndex != currentMaterial) {
+      glUniform1i(program.material, item.materialIndex);
+      currentMaterial = item.materialIndex;
+    }
+    if (item.vao != currentVao) {
+      currentVao = item.vao;
+      ++stats.vaoBinds;
+    }
+    const std::vector<uint8_t> &levels = object.lod->levels;
+    size_t level = item.meshIndex < levels.size() ? levels[item.meshIndex] : 0;
+    if (object.instanced) {
+      DrawMeshInstanced(*item.mesh, level, object.firstInstance,
+                        object.instanceCount);
+      stats.instances += object.instanceCount;
+    } else {
+      DrawMesh(*item.mesh, level);
+    }
+    ++stats.draws;
+  }
+  if (currentScope) {
+    EndGpuScope();
+  }
+  queue.stats = stats;
+}
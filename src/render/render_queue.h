@@ -0,0 +1,151 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "assets/geometry_buffer.h"
+#include "assets/mesh_lod.h"
+#include "assets/model.h"
+#include "math.h"
+#include "render/culling.h"
+
+// Pontos de ligação dos blocos Frame (câmara e luzes) e Object (matriz e
+// formato de vértice); Materials usa kMaterialBinding
+const GLuint kFrameBinding = 1;
+const GLuint kObjectBinding = 2;
+
+// Programa de meshes (pista e carros); câmara, luzes e dados do objeto vêm
+// dos blocos, só o material é um uniform solto
+struct MeshProgram {
+  GLuint program = 0;
+  GLint material = -1;
+  // Scope do profiler de GPU que mede os draws deste programa (nullptr =
+  // sem medição); programas seguidos com o mesmo nome partilham o scope
+  const char *gpuScope = nullptr;
+};
+
+struct DrawItem {
+  // Mesh e posição dele no modelo (índice no LodState)
+  const Mesh *mesh = nullptr;
+  uint32_t meshIndex = 0;
+  // Entrada no UBO de materiais e VAO do bloco de geometria
+  int materialIndex = 0;
+  GLuint vao = 0;
+};
+
+struct RenderModel {
+  // Modelo de onde vêm os arrays de texturas e o UBO de materiais
+  const Model *model = nullptr;
+  std::vector<DrawItem> items;
+  // Esfera do modelo inteiro (culling de cada instância de um lote)
+  Vec3 boundsCenter;
+  float boundsRadius = 0.0f;
+};
+
+struct FrameUniforms {
+  // Câmara e luzes do bloco Frame, iguais para todos os programas
+  Mat4 view;
+  Mat4 proj;
+  Vec3 lightDir;
+  Vec3 lightDir2;
+  Vec3 ambient;
+  Vec3 viewPos;
+};
+
+struct RenderStats {
+  // Contagens do último ExecuteRenderQueue
+  size_t draws = 0;
+  size_t programBinds = 0;
+  size_t materialBinds = 0;
+  size_t vaoBinds = 0;
+  size_t objectBinds = 0;
+  // Instâncias desenhadas por draws instanciados
+  size_t instances = 0;
+  // Culling: meshes de objetos e instâncias de lotes fora do frustum (não
+  // enviados), e objetos sem nenhum mesh visível
+  size_t culledDraws = 0;
+  size_t culledInstances = 0;
+  size_t visibleObjects = 0;
+  size_t culledObjects = 0;
+};
+
+struct QueuedObject {
+  const RenderModel *model = nullptr;
+  const MeshProgram *program = nullptr;
+  Mat4 transform;
+  const LodState *lod = nullptr;
+  // Lote instanciado: intervalo em RenderQueue::instances (os outros são
+  // desenhados com transform)
+  bool instanced = false;
+  uint32_t firstInstance = 0;
+  uint32_t instanceCount = 0;
+};
+
+struct QueuedDraw {
+  // Programa -> texturas -> VAO -> profundidade (da frente para trás)
+  uint64_t key = 0;
+  uint32_t object = 0;
+  uint32_t item = 0;
+};
+
+struct RenderQueue {
+  // UBO do frame (um bloco Frame) e dos objetos (um bloco Object por
+  // objeto, alinhado a GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT)
+  GLuint frameBuffer = 0;
+  GLuint objectBuffer = 0;
+  size_t objectStride = 0;
+  size_t objectCapacity = 0;
+  std::vector<unsigned char> objectData;
+  std::vector<QueuedObject> objects;
+  std::vector<QueuedDraw> draws;
+  // Matrizes e cores de todos os lotes do frame (um upload por frame)
+  std::vector<GpuInstance> instances;
+  // Esferas no mundo, paralelas a draws e a instances (culling)
+  SphereBatch drawSpheres;
+  SphereBatch instanceSpheres;
+  std::vector<uint8_t> visible;
+  // Ordem de chegada de programas, conjuntos de texturas e VAOs no frame
+  // (o slot entra na chave)
+  std::vector<GLuint> programs;
+  std::vector<const Model *> materialSets;
+  std::vector<GLuint> vaos;
+  RenderStats stats;
+};
+
+// Liga os blocos Frame, Object e Materials e lê a localização de uMaterial;
+// repetir depois de recompilar o programa
+MeshProgram QueryMeshProgram(GLuint program, const char *gpuScope = nullptr);
+// Cria os UBOs do frame e dos objetos (thread de GL)
+void InitRenderQueue(RenderQueue &queue);
+// Apaga os UBOs
+void CleanupRenderQueue(RenderQueue &queue);
+// Resolve uma vez os itens de desenho do modelo (mesh, material e VAO);
+// repetir se o modelo for recarregado
+RenderModel CompileRenderModel(const Model &model);
+// Esvazia a fila para um novo frame
+void BeginRenderQueue(RenderQueue &queue);
+// Junta os itens do modelo com a transformação e os LODs da instância; os
+// ponteiros têm de durar até ao ExecuteRenderQueue
+void SubmitRenderModel(RenderQueue &queue, const RenderModel &model,
+                       const MeshProgram &program, const Mat4 &transform,
+                       const LodState &lod, const Vec3 &eye);
+// Um lote de cópias do modelo (ex.: trânsito) num draw instanciado por mesh;
+// o programa tem de ler a matriz e a cor dos atributos de instância. A
+// profundidade da chave é a da instância mais próxima
+void SubmitInstancedModel(RenderQueue &queue, const RenderModel &model,
+                          const MeshProgram &program,
+                          const std::vector<GpuInstance> &instances,
+                          const LodState &lod, const Vec3 &eye);
+// Instância com a matriz e a cor dadas
+GpuInstance MakeInstance(const Mat4 &transform, const Vec3 &tint);
+// Matriz da instância mais próxima de eye (LOD e ordenação do lote)
+Mat4 NearestInstanceTransform(const std::vector<GpuInstance> &instances,
+                              const Vec3 &eye);
+// Descarta os meshes e instâncias fora do frustum de proj*view, escreve o
+// UBO do frame e todos os objetos de uma vez, ordena pela chave e desenha,
+// só mudando o estado quando muda de facto. Cada intervalo de programa
+// fica dentro do gpuScope dele
+void ExecuteRenderQueue(RenderQueue &queue, const FrameUniforms &frame);
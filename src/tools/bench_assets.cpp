@@ -0,0 +1,332 @@
+// Mede o carregamento de assets sem janela nem GL (make bench-assets):
+// LoadObj (parse e cache .pmesh), LoadMtl, descodificação das imagens e
+// normalização, na pista e em cópias dela 10x e 100x maiores. O resultado
+// sai em JSON para comparar versões do loader
+//
+// Uso: bench_assets <pista.obj> <saida.json> [repetições]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "assets/arena.h"
+#include "assets/model.h"
+#include "assets/texture.h"
+
+namespace {
+// Contadores do operator new global (todas as threads)
+std::atomic<size_t> gAllocations{0};
+std::atomic<size_t> gAllocatedBytes{0};
+}
+
+void *operator new(size_t size) {
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  gAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+// noinline: o GCC não deve ver o par new/free depois de expandir
+__attribute__((noinline)) void operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+__attribute__((noinline)) void operator delete(void *ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+namespace {
+struct Sample {
+  // Melhor tempo das repetições
+  double seconds = 0.0;
+  // Alocações e bytes pedidos numa repetição
+  size_t allocations = 0;
+  size_t allocatedBytes = 0;
+  // Pico de RSS (inclui o que já estava carregado antes)
+  size_t peakResidentBytes = 0;
+};
+
+struct BenchCase {
+  std::string name;
+  int scale = 1;
+  // Bytes de entrada e triângulos produzidos (0 = não se aplica)
+  size_t bytes = 0;
+  size_t triangles = 0;
+  // Memória temporária do loader (só LoadObj)
+  size_t transientPeakBytes = 0;
+  Sample sample;
+};
+
+BenchCase MakeCase(const std::string &name, int scale, size_t bytes = 0,
+                   size_t triangles = 0) {
+  BenchCase c;
+  c.name = name;
+  c.scale = scale;
+  c.bytes = bytes;
+  c.triangles = triangles;
+  return c;
+}
+
+// Corre setup() e fn() runs vezes; só fn() é medido
+template <typename Setup, typename Fn>
+Sample Measure(int runs, const Setup &setup, const Fn &fn) {
+  Sample best;
+  for (int run = 0; run < runs; ++run) {
+    setup();
+    // Base do pico para este caso (o bench corre um caso de cada vez)
+    ResetPeakResidentBytes();
+    size_t allocations = gAllocations.load();
+    size_t allocatedBytes = gAllocatedBytes.load();
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    if (run == 0 || seconds < best.seconds) {
+      best.seconds = seconds;
+    }
+    best.allocations = gAllocations.load() - allocations;
+    best.allocatedBytes = gAllocatedBytes.load() - allocatedBytes;
+    best.peakResidentBytes =
+        std::max(best.peakResidentBytes, PeakResidentBytes());
+  }
+  return best;
+}
+
+size_t CountTriangles(const Model &model) {
+  size_t triangles = 0;
+  for (const auto &mesh : model.meshes) {
+    triangles += mesh.indices.size() / 3;
+  }
+  return triangles;
+}
+
+// Soma offset aos índices positivos de um token de face (v/vt/vn)
+void OffsetFaceToken(std::string_view token, const size_t (&offsets)[3],
+                     std::string &out) {
+  for (int component = 0; component < 3 && !token.empty(); ++component) {
+    size_t slash = token.find('/');
+    std::string_view value = token.substr(0, slash);
+    if (!value.empty() && value[0] != '-') {
+      out += std::to_string(std::stoull(std::string(value)) +
+                            offsets[component]);
+    } else {
+      out += value;
+    }
+    if (slash == std::string_view::npos) {
+      break;
+    }
+    out += '/';
+    token.remove_prefix(slash + 1);
+  }
+}
+
+// Escreve scale cópias do OBJ lado a lado em X (índices relativos ficam
+// válidos porque cada cópia é o ficheiro inteiro)
+bool WriteScaledObj(const std::string &source, int scale,
+                    const std::string &target) {
+  std::ifstream in(source);
+  if (!in) {
+    return false;
+  }
+  std::vector<std::string> lines;
+  size_t counts[3] = {0, 0, 0};
+  float minX = 0.0f;
+  float maxX = 0.0f;
+  for (std::string line; std::getline(in, line);) {
+    if (line.compare(0, 2, "v ") == 0) {
+      float x = std::strtof(line.c_str() + 2, nullptr);
+      minX = counts[0] == 0 ? x : std::min(minX, x);
+      maxX = counts[0] == 0 ? x : std::max(maxX, x);
+      ++counts[0];
+    } else if (line.compare(0, 3, "vt ") == 0) {
+      ++counts[1];
+    } else if (line.compare(0, 3, "vn ") == 0) {
+      ++counts[2];
+    }
+    lines.push_back(std::move(line));
+  }
+
+  std::ofstream out(target);
+  float step = (maxX - minX) * 1.1f + 1.0f;
+  std::string text;
+  for (int copy = 0; copy < scale; ++copy) {
+    size_t offsets[3] = {counts[0] * copy, counts[1] * copy,
+                         counts[2] * copy};
+    for (const std::string &line : lines) {
+      text.clear();
+      if (line.compare(0, 2, "v ") == 0) {
+        char *rest = nullptr;
+        float x = std::strtof(line.c_str() + 2, &rest);
+        text = "v " + std::to_string(x + step * copy) + rest;
+      } else if (line.compare(0, 2, "f ") == 0) {
+        text = "f";
+        std::string_view tokens(line);
+        tokens.remove_prefix(2);
+        while (!tokens.empty()) {
+          size_t space = tokens.find(' ');
+          std::string_view token = tokens.substr(0, space);
+          if (!token.empty()) {
+            text += ' ';
+            OffsetFaceToken(token, offsets, text);
+          }
+          tokens.remove_prefix(space == std::string_view::npos ? tokens.size()
+                                                               : space + 1);
+        }
+      } else if (line.compare(0, 7, "mtllib ") == 0 && copy > 0) {
+        continue;
+      } else {
+        text = line;
+      }
+      out << text << '\n';
+    }
+  }
+  return static_cast<bool>(out);
+}
+
+void WriteJson(std::ostream &out, const std::string &source, int runs,
+               const std::vector<BenchCase> &cases) {
+  const double mb = 1024.0 * 1024.0;
+  out << std::setprecision(6) << "{\n";
+  out << "  \"source\": \"" << source << "\",\n";
+  out << "  \"runs\": " << runs << ",\n";
+  out << "  \"hardware_threads\": " << std::thread::hardware_concurrency()
+      << ",\n";
+  out << "  \"cases\": [\n";
+  for (size_t i = 0; i < cases.size(); ++i) {
+    const BenchCase &c = cases[i];
+    const Sample &s = c.sample;
+    out << "    {\"name\": \"" << c.name << "\", \"scale\": " << c.scale
+        << ", \"seconds\": " << s.seconds << ", \"bytes\": " << c.bytes
+        << ", \"mb_per_s\": "
+        << (s.seconds > 0.0 ? c.bytes / mb / s.seconds : 0.0)
+        << ", \"triangles\": " << c.triangles << ", \"triangles_per_s\": "
+        << (s.seconds > 0.0 ? c.triangles / s.seconds : 0.0)
+        << ", \"allocations\": " << s.allocations
+        << ", \"allocated_bytes\": " << s.allocatedBytes
+        << ", \"peak_rss_bytes\": " << s.peakResidentBytes
+        << ", \"transient_peak_bytes\": " << c.transientPeakBytes << "}"
+        << (i + 1 < cases.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n}\n";
+}
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Uso: " << argv[0]
+              << " <pista.obj> <saida.json> [repeticoes]\n";
+    return 1;
+  }
+  namespace fs = std::filesystem;
+  const std::string source = argv[1];
+  const int runs = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+  std::vector<BenchCase> cases;
+
+  // Materiais e imagens da pista original (não dependem da escala)
+  fs::path mtlPath = fs::path(source).replace_extension(".mtl");
+  std::unordered_map<std::string, Material> materials;
+  BenchCase mtl = MakeCase("mtl", 1, fs::file_size(mtlPath));
+  mtl.sample = Measure(
+      runs, [&]() { materials.clear(); },
+      [&]() { LoadMtl(mtlPath.string(), materials); });
+  cases.push_back(mtl);
+
+  std::unordered_set<std::string> images;
+  for (const auto &entry : materials) {
+    if (!entry.second.mapKd.empty() && fs::exists(entry.second.mapKd)) {
+      images.insert(entry.second.mapKd);
+    }
+  }
+  BenchCase decode = MakeCase("image_decode", 1);
+  for (const std::string &image : images) {
+    decode.bytes += fs::file_size(image);
+  }
+  decode.sample = Measure(
+      runs, []() {},
+      [&]() {
+        for (const std::string &image : images) {
+          DecodedImage decoded;
+          DecodeImage(image, decoded);
+          FreeDecodedImage(decoded);
+        }
+      });
+  cases.push_back(decode);
+
+  // Cópias da pista numa pasta temporária (com o MTL ao lado)
+  fs::path workDir = fs::temp_directory_path() / "bench_assets";
+  fs::create_directories(workDir);
+  fs::copy_file(mtlPath, workDir / mtlPath.filename(),
+                fs::copy_options::overwrite_existing);
+  for (int scale : {1, 10, 100}) {
+    std::string objPath =
+        (workDir / ("pista_x" + std::to_string(scale) + ".obj")).string();
+    if (!WriteScaledObj(source, scale, objPath)) {
+      std::cerr << "Falha ao gerar " << objPath << "\n";
+      return 1;
+    }
+    size_t bytes = fs::file_size(objPath);
+
+    // Parse completo, sem cache
+    // (sem relatórios no stdout: a memória chega por ObjLoadStats)
+    ObjLoadConfig config;
+    config.useCache = false;
+    Model model;
+    ObjLoadStats stats;
+    BenchCase parse = MakeCase("obj_parse", scale, bytes);
+    parse.sample = Measure(
+        runs, [&]() { model = Model{}; },
+        [&]() { LoadObj(objPath, model, config, &stats); });
+    parse.triangles = CountTriangles(model);
+    parse.transientPeakBytes = stats.transientPeakBytes;
+    cases.push_back(parse);
+
+    // Leitura do .pmesh (gerado antes, fora da medição)
+    config.useCache = true;
+    LoadObj(objPath, model, config);
+    fs::path cachePath = fs::path(objPath).replace_extension(".pmesh");
+    BenchCase cached = MakeCase(
+        "obj_cache", scale,
+        fs::exists(cachePath) ? fs::file_size(cachePath) : 0);
+    cached.sample = Measure(
+        runs, [&]() { model = Model{}; },
+        [&]() { LoadObj(objPath, model, config, &stats); });
+    cached.triangles = CountTriangles(model);
+    cached.transientPeakBytes = stats.transientPeakBytes;
+    cases.push_back(cached);
+
+    // Caixa envolvente, centro/escala e volumes dos meshes
+    Model normalized;
+    BenchCase bounds = MakeCase("normalize", scale, 0, CountTriangles(model));
+    for (const auto &mesh : model.meshes) {
+      bounds.bytes += mesh.vertices.size() * sizeof(Vertex);
+    }
+    bounds.sample = Measure(
+        runs, [&]() { normalized = model; },
+        [&]() { NormalizeModel(normalized); });
+    cases.push_back(bounds);
+  }
+  std::error_code ec;
+  fs::remove_all(workDir, ec);
+
+  std::ofstream json(argv[2]);
+  WriteJson(json, source, runs, cases);
+  if (!json) {
+    std::cerr << "Falha ao escrever " << argv[2] << "\n";
+    return 1;
+  }
+  WriteJson(std::cout, source, runs, cases);
+  return 0;
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+// Substituto do GLEW para ferramentas sem janela (make bench-assets): só
+// tipos, constantes e chamadas vazias, para o código de assets compilar e
+// ligar sem contexto nem libGL. Nenhum resultado de GL é real.
+
+#include <cstddef>
+#include <cstdint>
+
+typedef unsigned int GLenum;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+typedef unsigned int GLbitfield;
+typedef unsigned char GLboolean;
+typedef float GLfloat;
+typedef char GLchar;
+typedef ptrdiff_t GLsizeiptr;
+typedef ptrdiff_t GLintptr;
+
+#define GL_FALSE 0
+#define GL_TRUE 1
+#define GL_TRIANGLES 0x0004
+#define GL_SHORT 0x1402
+#define GL_UNSIGNED_BYTE 0x1401
+#define GL_UNSIGNED_SHORT 0x1403
+#define GL_UNSIGNED_INT 0x1405
+#define GL_FLOAT 0x1406
+#define GL_HALF_FLOAT 0x140B
+#define GL_RGBA 0x1908
+#define GL_RGBA8 0x8058
+#define GL_LINEAR 0x2601
+#define GL_LINEAR_MIPMAP_LINEAR 0x2703
+#define GL_REPEAT 0x2901
+#define GL_TEXTURE_MAG_FILTER 0x2800
+#define GL_TEXTURE_MIN_FILTER 0x2801
+#define GL_TEXTURE_WRAP_S 0x2802
+#define GL_TEXTURE_WRAP_T 0x2803
+#define GL_TEXTURE_2D 0x0DE1
+#define GL_TEXTURE_2D_ARRAY 0x8C1A
+#define GL_TEXTURE_BASE_LEVEL 0x813C
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#define GL_TEXTURE0 0x84C0
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#define GL_UNIFORM_BUFFER 0x8A11
+#define GL_COPY_WRITE_BUFFER 0x8F37
+#define GL_STREAM_DRAW 0x88E0
+#define GL_STATIC_DRAW 0x88E4
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+
+// Sem extensões: as texturas ficam em RGBA8
+#define GLEW_EXT_texture_compression_s3tc false
+
+// Objetos
+inline void glGenTextures(GLsizei, GLuint *ids) { *ids = 0; }
+inline void glDeleteTextures(GLsizei, const GLuint *) {}
+inline void glGenBuffers(GLsizei, GLuint *ids) { *ids = 0; }
+inline void glDeleteBuffers(GLsizei, const GLuint *) {}
+inline void glGenVertexArrays(GLsizei, GLuint *ids) { *ids = 0; }
+inline void glDeleteVertexArrays(GLsizei, const GLuint *) {}
+
+// Texturas
+inline void glActiveTexture(GLenum) {}
+inline void glBindTexture(GLenum, GLuint) {}
+inline void glTexParameteri(GLenum, GLenum, GLint) {}
+inline void glTexImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint,
+                         GLenum, GLenum, const void *) {}
+inline void glTexImage3D(GLenum, GLint, GLint, GLsizei, GLsizei, GLsizei,
+                         GLint, GLenum, GLenum, const void *) {}
+inline void glCompressedTexImage2D(GLenum, GLint, GLenum, GLsizei, GLsizei,
+                                   GLint, GLsizei, const void *) {}
+inline void glCompressedTexImage3D(GLenum, GLint, GLenum, GLsizei, GLsizei,
+                                   GLsizei, GLint, GLsizei, const void *) {}
+inline void glTexSubImage3D(GLenum, GLint, GLint, GLint, GLint, GLsizei,
+                            GLsizei, GLsizei, GLenum, GLenum, const void *) {}
+inline void glCompressedTexSubImage3D(GLenum, GLint, GLint, GLint, GLint,
+                                      GLsizei, GLsizei, GLsizei, GLenum,
+                                      GLsizei, const void *) {}
+inline void glGenerateMipmap(GLenum) {}
+
+// Buffers e vértices
+inline void glBindBuffer(GLenum, GLuint) {}
+inline void glBindBufferBase(GLenum, GLuint, GLuint) {}
+inline void glBufferData(GLenum, GLsizeiptr, const void *, GLenum) {}
+inline void glBufferSubData(GLenum, GLintptr, GLsizeiptr, const void *) {}
+inline void *glMapBufferRange(GLenum, GLintptr, GLsizeiptr, GLbitfield) {
+  return nullptr;
+}
+inline GLboolean glUnmapBuffer(GLenum) { return GL_TRUE; }
+inline void glBindVertexArray(GLuint) {}
+inline void glEnableVertexAttribArray(GLuint) {}
+inline void glVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei,
+                                  const void *) {}
+inline void glDrawElementsBaseVertex(GLenum, GLsizei, GLenum, const void *,
+                                     GLint) {}
+inline void glDrawElementsInstancedBaseVertex(GLenum, GLsizei, GLenum,
+                                              const void *, GLsizei, GLint) {}
+inline void glVertexAttribDivisor(GLuint, GLuint) {}
+
+// Shaders e programas
+inline GLuint glCreateShader(GLenum) { return 0; }
+inline void glShaderSource(GLuint, GLsizei, const GLchar *const *,
+                           const GLint *) {}
+inline void glCompileShader(GLuint) {}
+inline void glGetShaderiv(GLuint, GLenum, GLint *value) { *value = 0; }
+inline void glGetShaderInfoLog(GLuint, GLsizei, GLsizei *, GLchar *) {}
+inline void glDeleteShader(GLuint) {}
+inline GLuint glCreateProgram() { return 0; }
+inline void glAttachShader(GLuint, GLuint) {}
+inline void glLinkProgram(GLuint) {}
+inline void glGetProgramiv(GLuint, GLenum, GLint *value) { *value = 0; }
+inline void glGetProgramInfoLog(GLuint, GLsizei, GLsizei *, GLchar *) {}
+inline void glDeleteProgram(GLuint) {}
+inline void glUseProgram(GLuint) {}
+inline GLint glGetUniformLocation(GLuint, const GLchar *) { return -1; }
+inline GLuint glGetUniformBlockIndex(GLuint, const GLchar *) {
+  return GL_INVALID_INDEX;
+}
+inline void glUniformBlockBinding(GLuint, GLuint, GLuint) {}
+inline void glUniform1iv(GLint, GLsizei, const GLint *) {}
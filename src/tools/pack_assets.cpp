@@ -0,0 +1,102 @@
+// Gera o arquivo de assets: pré-processa os modelos (.pmesh) e as texturas
+// dos materiais (.ptex) e junta tudo, com shaders e imagens, num só .pak
+//
+// Uso: pack_assets <saida.pak> <pasta|ficheiro>...
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "assets/asset_archive.h"
+#include "assets/model.h"
+#include "assets/texture.h"
+
+namespace {
+// Extensões que entram no arquivo
+bool IsPackedExtension(const std::string &ext) {
+  static const char *kExtensions[] = {".obj", ".mtl", ".pmesh", ".png",
+                                      ".jpg", ".jpeg", ".ptex", ".vs",
+                                      ".fs"};
+  for (const char *packed : kExtensions) {
+    if (ext == packed) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Lista os ficheiros de uma pasta (recursivo) ou o próprio ficheiro
+void CollectFiles(const std::string &root, std::vector<std::string> &files) {
+  namespace fs = std::filesystem;
+  if (fs::is_regular_file(root)) {
+    files.push_back(fs::path(root).lexically_normal().generic_string());
+    return;
+  }
+  std::error_code ec;
+  for (auto it = fs::recursive_directory_iterator(root, ec);
+       !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+    if (it->is_regular_file()) {
+      files.push_back(it->path().lexically_normal().generic_string());
+    }
+  }
+}
+
+// Carrega cada modelo uma vez para gerar/atualizar os caches ao lado
+void BakeModel(const std::string &objPath) {
+  Model model;
+  if (!LoadObj(objPath, model)) {
+    return;
+  }
+  // Camadas no tamanho do grupo em que o jogo as vai pôr
+  for (const TextureGroup &group : PlanTextureGroups(model)) {
+    for (const std::string &path : group.paths) {
+      MipChain layer;
+      DecodeTextureLayer(path, group.layerSize, true, layer);
+    }
+  }
+}
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Uso: " << argv[0] << " <saida.pak> <pasta|ficheiro>...\n";
+    return 1;
+  }
+
+  // Primeiro os caches, para que entrem na listagem a seguir
+  std::vector<std::string> files;
+  for (int i = 2; i < argc; ++i) {
+    CollectFiles(argv[i], files);
+  }
+  for (const auto &file : files) {
+    if (std::filesystem::path(file).extension() == ".obj") {
+      BakeModel(file);
+    }
+  }
+
+  // Listagem final (ordenada para o arquivo ser reprodutível)
+  files.clear();
+  for (int i = 2; i < argc; ++i) {
+    CollectFiles(argv[i], files);
+  }
+  files.erase(std::remove_if(files.begin(), files.end(),
+                             [](const std::string &file) {
+                               return !IsPackedExtension(
+                                   std::filesystem::path(file)
+                                       .extension()
+                                       .string());
+                             }),
+              files.end());
+  std::sort(files.begin(), files.end());
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+
+  if (!WriteAssetArchive(argv[1], files)) {
+    return 1;
+  }
+  std::cout << "Arquivo " << argv[1] << ": " << files.size()
+            << " ficheiros, " << std::filesystem::file_size(argv[1])
+            << " bytes\n";
+  return 0;
+}